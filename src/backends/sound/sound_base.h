@@ -15,6 +15,10 @@ int Backend_Sound_Init();
 int Backend_Sound_Update(int size);
 int Backend_Sound_Close();
 
+// Stereo samples queued for playback but not played yet, and how many
+// can be queued at most (-1 if the backend can't tell)
+int Backend_Sound_GetQueued(int *capacity);
+
 int Backend_Sound_PlayMusic(char *path);
 int Backend_Sound_IsPlayingMusic();
 int Backend_Sound_StopMusic();
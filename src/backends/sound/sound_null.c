@@ -3,7 +3,9 @@
 int Backend_Sound_Init() { return 1; }
 int Backend_Sound_Update(int size) { return 1; }
 int Backend_Sound_Close() { return 1; }
+int Backend_Sound_GetQueued(int *capacity) { return -1; }
 int Backend_Sound_PlayMusic(char *path) { return 1; }
+int Backend_Sound_IsPlayingMusic() { return 0; }
 int Backend_Sound_StopMusic() { return 1; }
 int Backend_Sound_FadeOutMusic(int fadeTime) { return 1; }
 int Backend_Sound_MusicSpeed(float speed) { return 1; }
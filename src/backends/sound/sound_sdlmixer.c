@@ -139,6 +139,11 @@ int Backend_Sound_Update(int size) {
   return 1;
 }
 
+int Backend_Sound_GetQueued(int *capacity) {
+  /* Channel callback resynchronizes on its own */
+  return -1;
+}
+
 int Backend_Sound_MusicSpeed(float speed) { return 1; }
 int Backend_Sound_MusicSetUnderwater(int isUnderwater) { return 1; }
 int Backend_Sound_PlaySFX(char *path) { return 1; }
@@ -23,6 +23,7 @@ Bus filter_bus;
 float music_speed = 1.0;
 
 int whichchunk = 0;
+int chunk_samples = 0;
 Wav *chunks[CHUNK_BUFFER_SIZE];
 Queue chunkqueue;
 
@@ -91,6 +92,7 @@ int Backend_Sound_Update(int size) {
     soloud.unlockAudioMutex_internal();
 
     chunkqueue.play(*chunk);
+    chunk_samples = chunk->mSampleCount;
     whichchunk++;
     whichchunk %= CHUNK_BUFFER_SIZE;
 
@@ -100,6 +102,13 @@ int Backend_Sound_Update(int size) {
     return 1;
 }
 
+int Backend_Sound_GetQueued(int *capacity) {
+    // Chunks are all about one frame long, and Update drops any chunk
+    // past CHUNK_BUFFER_SIZE - 1 queued ones
+    *capacity = (CHUNK_BUFFER_SIZE - 1) * chunk_samples;
+    return chunkqueue.getQueueCount() * chunk_samples;
+}
+
 int Backend_Sound_IsPlayingMusic() {
     return soloud.isValidVoiceHandle(music_handle);
 }
@@ -1,7 +1,7 @@
 #ifndef __BACKEND_VIDEO_BASE___
 #define __BACKEND_VIDEO_BASE___
 
-#define VIDEO_WIDTH  400
+#define VIDEO_WIDTH  (config_legacy.screen_width)
 #define VIDEO_HEIGHT 224
 
 #define WINDOW_SCALE 3
@@ -9,6 +9,16 @@
 extern int option_mirrormode;
 extern int option_scaling;
 
+/* Frame uploaded by Backend_Video_Update (bitmap.data, unless the */
+/* emulation runs on its own thread and renders somewhere else) */
+extern unsigned char *video_frame;
+
+/* Rows of video_frame that changed since the previous update, as          */
+/* (first row, row count) runs; a negative count means the whole frame did */
+#define VIDEO_DIRTY_MAX 8
+extern int video_dirty[VIDEO_DIRTY_MAX][2];
+extern int video_dirty_count;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
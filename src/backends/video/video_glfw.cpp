@@ -10,6 +10,15 @@
 #include <GLFW/glfw3.h> // GLFW helper library
 
 #include "shared.h"
+#include "config.h"
+#include "video_gpu.h"
+
+// Byte order of the core's 32-bit output pixels (see PIXEL() in vdp_render.h)
+#if defined(USE_ABGR)
+  #define TEXTURE_FORMAT GL_RGBA
+#else
+  #define TEXTURE_FORMAT GL_BGRA
+#endif
 
 const char *shader_src_vert_builtin =
   "attribute vec3 vp;"
@@ -44,10 +53,20 @@ const float uv_2p[] = {
 int fullscreen = 0;
 
 GLuint shader, buf_vert, array_vert, buf_uv, tex_screen;
+#ifdef USE_GPU_RENDER
+GLuint tex_frame; // CPU framebuffer, composited into tex_screen
+#endif
 GLFWwindow *window;
 void *window_shared;
 
 int Backend_Video_Close() {
+  #ifdef USE_GPU_RENDER
+    if (tex_frame) {
+      render_gpu = 0;
+      Video_Gpu_Close();
+      glDeleteTextures(1, &tex_frame);
+    }
+  #endif
 	glfwTerminate();
   return 1;
 };
@@ -167,8 +186,15 @@ int Backend_Video_Present() {
 
   glUseProgram(shader);
   glBindVertexArray(array_vert);
+  // Backdrop is output as a transparent key pixel while BG layers are disabled
+  int blend = render_bg_disable;
+  if (blend) {
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  }
   // draw points 0-3 from the currently bound array_vert with current in-use shader
   glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+  if (blend) glDisable(GL_BLEND);
   // update other events like input handling 
   glfwPollEvents();
   // put the stuff we've been drawing onto the display
@@ -260,15 +286,36 @@ int Backend_Video_Init() {
   glTexImage2D(
     GL_TEXTURE_2D,
     0, // lod
-    GL_RGB,
-    400, // width
+    GL_RGBA, // keep alpha for the transparent key pixel
+    VIDEO_WIDTH, // width
     448, // height (* 2 for multiplayer)
     0, // border (useless)
-    GL_BGRA,
+    TEXTURE_FORMAT,
     GL_UNSIGNED_BYTE,
     bitmap.data
   );
 
+  #ifdef USE_GPU_RENDER
+    if (config_legacy.gpu_render && Video_Gpu_Init(TEXTURE_FORMAT)) {
+      glGenTextures(1, &tex_frame);
+      glBindTexture(GL_TEXTURE_2D, tex_frame);
+      glTexImage2D(
+        GL_TEXTURE_2D,
+        0, // lod
+        GL_RGBA,
+        VIDEO_WIDTH, // width
+        448, // height (* 2 for multiplayer)
+        0, // border (useless)
+        TEXTURE_FORMAT,
+        GL_UNSIGNED_BYTE,
+        bitmap.data
+      );
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      render_gpu = 1;
+    }
+  #endif
+
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
   return 1;
@@ -303,18 +350,50 @@ int Backend_Video_ToggleFullscreen() {
 };
 
 int Backend_Video_Update() {
-  glBindTexture(GL_TEXTURE_2D, tex_screen);
-  glTexSubImage2D(
-    GL_TEXTURE_2D,
-    0, // lod
-    0,
-    0,
-    400, // width
-    448, // height (* 2 for multiplayer)
-    GL_BGRA,
-    GL_UNSIGNED_BYTE,
-    bitmap.data
-  );
+  #ifdef USE_GPU_RENDER
+    glBindTexture(GL_TEXTURE_2D, render_gpu ? tex_frame : tex_screen);
+  #else
+    glBindTexture(GL_TEXTURE_2D, tex_screen);
+  #endif
+
+  if (video_dirty_count >= 0) {
+    // Rows the core did not rewrite are already in the texture
+    for (int i = 0; i < video_dirty_count; i++) {
+      int y = video_dirty[i][0];
+      int rows = video_dirty[i][1];
+      if (y >= 448) break;
+      if ((y + rows) > 448) rows = 448 - y;
+
+      glTexSubImage2D(
+        GL_TEXTURE_2D,
+        0, // lod
+        0,
+        y,
+        VIDEO_WIDTH, // width
+        rows,
+        TEXTURE_FORMAT,
+        GL_UNSIGNED_BYTE,
+        video_frame + (y * bitmap.pitch)
+      );
+    }
+  } else {
+    glTexSubImage2D(
+      GL_TEXTURE_2D,
+      0, // lod
+      0,
+      0,
+      VIDEO_WIDTH, // width
+      448, // height (* 2 for multiplayer)
+      TEXTURE_FORMAT,
+      GL_UNSIGNED_BYTE,
+      video_frame
+    );
+  }
+
+  #ifdef USE_GPU_RENDER
+    // Leaves tex_screen bound
+    if (render_gpu) Video_Gpu_Composite(tex_frame, tex_screen);
+  #endif
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -0,0 +1,263 @@
+#include "video_base.h"
+
+#ifdef USE_GPU_RENDER
+
+#if defined(GL_LOADER_GLEW)
+  #include <GL/glew.h>
+#elif defined(GL_LOADER_GLAD)
+  #include <glad/glad.h>
+#else
+  #error No GL_LOADER_x defined.
+#endif
+
+#include "shared.h"
+#include "video_gpu.h"
+
+// Layer priority tables used by Mode 5 (see render_init)
+#define GPU_LUTS 5
+
+// Fullscreen quad, drawn as a 4 vertex strip without any vertex data
+static const char *gpu_src_vert =
+  "#version 130\n"
+  "void main() {"
+    "vec2 p = vec2(gl_VertexID & 1, gl_VertexID >> 1);"
+    "gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);"
+  "}";
+
+// One fragment per output pixel: same steps as render_bg_m5 & render_obj_m5,
+// with the merges done through the core's priority tables
+static const char *gpu_src_frag =
+  "#version 130\n"
+  "uniform sampler2D frame;"
+  "uniform isampler2D lines;"
+  "uniform usampler2D cells;"
+  "uniform isampler2D sprites;"
+  "uniform usampler2D patterns;"
+  "uniform usampler2D luts;"
+  "uniform sampler2D palettes;"
+  "uniform int rows;"
+  "uniform int width;"
+  "out vec4 color;"
+
+  "int lut(int n, int b, int a) {"
+    "return int(texelFetch(luts, ivec2(a, (n << 8) | b), 0).r);"
+  "}"
+
+  // Pattern pixel, name & flip bits as in a name table word
+  "int pattern(int name, int row, int col) {"
+    "if ((name & 0x1000) != 0) row ^= 7;"
+    "if ((name & 0x0800) != 0) col ^= 7;"
+    "int i = ((name & 0x7FF) << 3) | row;"
+    "uint bits = texelFetch(patterns, ivec2(i & 127, i >> 7), 0).r;"
+    "return int(bits >> uint(28 - (col << 2))) & 15;"
+  "}"
+
+  // Layer pixel (0Pppcccc) from the cells following each other from pos
+  "int cell(int layer, int y, int pos, int x) {"
+    "int k = x - pos;"
+    "uint c = texelFetch(cells, ivec2((layer << 6) | (k >> 3), y), 0).r;"
+    "int attr = int(c & 0xFFFFu);"
+    "return pattern(attr, int(c >> 16), k & 7) | ((attr >> 9) & 0x70);"
+  "}"
+
+  "void main() {"
+    "ivec2 p = ivec2(gl_FragCoord.xy);"
+    "ivec4 l0 = ((p.y < rows) && (p.x < width)) ? texelFetch(lines, ivec2(0, p.y), 0) : ivec4(0);"
+    "if (l0.x == 0) { color = texelFetch(frame, p, 0); return; }"
+    "ivec4 l1 = texelFetch(lines, ivec2(1, p.y), 0);"
+    "ivec4 l2 = texelFetch(lines, ivec2(2, p.y), 0);"
+    "if ((p.x >= l2.x) && (p.x < l2.y)) { color = texelFetch(palettes, ivec2(0x40, l0.y), 0); return; }"
+
+    // Planes B, A & window
+    "int b = cell(0, p.y, l0.w, p.x);"
+    "int a = 0;"
+    "if ((p.x >= l1.z) && (p.x < l1.w)) a = cell(2, p.y, l1.z, p.x);"
+    "else if ((p.x >= l1.x) && (p.x < l1.y)) a = cell(1, p.y, l1.x, p.x);"
+    "int pix = lut(((l0.x & 2) != 0) ? 2 : 0, b, a);"
+
+    // Sprites, front to back
+    "bool ste = (l0.x & 4) != 0;"
+    "int spr = 0;"
+    "for (int i = 0; i < l0.z; i++) {"
+      "ivec4 s = texelFetch(sprites, ivec2(i, p.y), 0);"
+      "int k = p.x - s.x;"
+      "if ((k < 0) || (k >= ((s.y & 0xFF) << 3))) continue;"
+      "int col = k >> 3;"
+      "int c = pattern((s[2 + (col >> 1)] >> ((col & 1) << 4)) & 0xFFFF, (s.y >> 16) & 7, k & 7);"
+      "if (c == 0) continue;"
+      "c |= (s.y >> 8) & 0x70;"
+      "if (ste) spr = lut(3, spr, c); else pix = lut(1, pix, c);"
+    "}"
+    "if (ste) pix = lut(4, pix, spr);"
+
+    "color = texelFetch(palettes, ivec2(pix, l0.y), 0);"
+  "}";
+
+static GLuint gpu_program, gpu_array, gpu_fbo;
+static GLuint tex_lines, tex_cells, tex_sprites, tex_patterns, tex_luts, tex_palettes;
+static GLint gpu_rows, gpu_width;
+static GLenum gpu_format;
+static int gpu_luts_ready;
+
+static GLuint Gpu_Shader(const char *source, GLenum type) {
+  GLint success;
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &source, NULL);
+  glCompileShader(shader);
+
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+  if (success != GL_TRUE) {
+    char log_string[1024];
+    glGetShaderInfoLog(shader, sizeof(log_string), NULL, log_string);
+    printf("GPU render shader failed to compile:\n%s\n", log_string);
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+static GLuint Gpu_Texture(GLint internal, int width, int height, GLenum format, GLenum type) {
+  GLuint tex;
+  glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, internal, width, height, 0, format, type, NULL);
+
+  // Fetched texel by texel, but integer textures must not ask for mipmaps
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  return tex;
+}
+
+static void Gpu_Bind(int unit, const char *name, GLuint tex) {
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glUniform1i(glGetUniformLocation(gpu_program, name), unit);
+}
+
+int Video_Gpu_Init(unsigned int format) {
+  GLint major = 0, success;
+
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  if (major < 3) {
+    printf("GPU render needs OpenGL 3.0, drawing on the CPU\n");
+    return 0;
+  }
+
+  GLuint vs = Gpu_Shader(gpu_src_vert, GL_VERTEX_SHADER);
+  GLuint fs = Gpu_Shader(gpu_src_frag, GL_FRAGMENT_SHADER);
+  if (!vs || !fs) return 0;
+
+  gpu_program = glCreateProgram();
+  glAttachShader(gpu_program, vs);
+  glAttachShader(gpu_program, fs);
+  glBindFragDataLocation(gpu_program, 0, "color");
+  glLinkProgram(gpu_program);
+  glDeleteShader(vs);
+  glDeleteShader(fs);
+
+  glGetProgramiv(gpu_program, GL_LINK_STATUS, &success);
+  if (success != GL_TRUE) {
+    printf("GPU render program failed to link\n");
+    glDeleteProgram(gpu_program);
+    gpu_program = 0;
+    return 0;
+  }
+
+  gpu_rows = glGetUniformLocation(gpu_program, "rows");
+  gpu_width = glGetUniformLocation(gpu_program, "width");
+  gpu_format = format;
+
+  tex_lines = Gpu_Texture(GL_RGBA32I, sizeof(t_gpu_line) / 16, GPU_LINES_MAX, GL_RGBA_INTEGER, GL_INT);
+  tex_cells = Gpu_Texture(GL_R32UI, 3 * GPU_CELLS, GPU_LINES_MAX, GL_RED_INTEGER, GL_UNSIGNED_INT);
+  tex_sprites = Gpu_Texture(GL_RGBA32I, GPU_SPRITES_MAX, GPU_LINES_MAX, GL_RGBA_INTEGER, GL_INT);
+  tex_patterns = Gpu_Texture(GL_R32UI, 128, 128, GL_RED_INTEGER, GL_UNSIGNED_INT);
+  tex_luts = Gpu_Texture(GL_R8UI, 256, 256 * GPU_LUTS, GL_RED_INTEGER, GL_UNSIGNED_BYTE);
+  tex_palettes = Gpu_Texture(GL_RGBA, 256, GPU_PALETTES_MAX, format, GL_UNSIGNED_BYTE);
+  gpu_luts_ready = 0;
+
+  glGenVertexArrays(1, &gpu_array);
+  glGenFramebuffers(1, &gpu_fbo);
+
+  return 1;
+}
+
+void Video_Gpu_Close() {
+  GLuint textures[] = { tex_lines, tex_cells, tex_sprites, tex_patterns, tex_luts, tex_palettes };
+
+  if (!gpu_program) return;
+
+  glDeleteTextures(sizeof(textures) / sizeof(textures[0]), textures);
+  glDeleteFramebuffers(1, &gpu_fbo);
+  glDeleteVertexArrays(1, &gpu_array);
+  glDeleteProgram(gpu_program);
+  gpu_program = 0;
+}
+
+void Video_Gpu_Composite(unsigned int tex_frame, unsigned int tex_target) {
+  int rows = gpu_frame.lines;
+  GLint viewport[4], array;
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  // Tables are built once by render_init, before the first frame
+  if (!gpu_luts_ready) {
+    glBindTexture(GL_TEXTURE_2D, tex_luts);
+    for (int i = 0; i < GPU_LUTS; i++)
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, i * 256, 256, 256, GL_RED_INTEGER, GL_UNSIGNED_BYTE, render_lut(i));
+    gpu_luts_ready = 1;
+  }
+
+  if (rows) {
+    glBindTexture(GL_TEXTURE_2D, tex_lines);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeof(t_gpu_line) / 16, rows, GL_RGBA_INTEGER, GL_INT, gpu_frame.line);
+
+    glBindTexture(GL_TEXTURE_2D, tex_cells);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 3 * GPU_CELLS, rows, GL_RED_INTEGER, GL_UNSIGNED_INT, gpu_frame.cells);
+
+    // Only as many sprite columns as the busiest line needs
+    if (gpu_frame.sprites) {
+      glBindTexture(GL_TEXTURE_2D, tex_sprites);
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, GPU_SPRITES_MAX);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, gpu_frame.sprites, rows, GL_RGBA_INTEGER, GL_INT, gpu_frame.sprite);
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, tex_patterns);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 128, 128, GL_RED_INTEGER, GL_UNSIGNED_INT, gpu_frame.pattern);
+
+    glBindTexture(GL_TEXTURE_2D, tex_palettes);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, gpu_frame.palettes, gpu_format, GL_UNSIGNED_BYTE, gpu_frame.palette);
+  }
+
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &array);
+  glBindFramebuffer(GL_FRAMEBUFFER, gpu_fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex_target, 0);
+  glViewport(0, 0, VIDEO_WIDTH, 448);
+
+  // Output replaces the texture, key pixels included
+  glDisable(GL_BLEND);
+
+  glUseProgram(gpu_program);
+  glUniform1i(gpu_rows, rows);
+  glUniform1i(gpu_width, bitmap.viewport.w);
+  Gpu_Bind(0, "frame", tex_frame);
+  Gpu_Bind(1, "lines", tex_lines);
+  Gpu_Bind(2, "cells", tex_cells);
+  Gpu_Bind(3, "sprites", tex_sprites);
+  Gpu_Bind(4, "patterns", tex_patterns);
+  Gpu_Bind(5, "luts", tex_luts);
+  Gpu_Bind(6, "palettes", tex_palettes);
+  glActiveTexture(GL_TEXTURE0);
+
+  glBindVertexArray(gpu_array);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  // Back to presenting tex_target
+  glBindVertexArray(array);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  glBindTexture(GL_TEXTURE_2D, tex_target);
+}
+
+#endif /* USE_GPU_RENDER */
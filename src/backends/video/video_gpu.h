@@ -0,0 +1,17 @@
+#ifndef __BACKEND_VIDEO_GPU___
+#define __BACKEND_VIDEO_GPU___
+
+/* GPU compositing of the lines captured by the core (GPU_RENDER=1): the  */
+/* frame is drawn from gpu_frame into a texture, rows the core drew       */
+/* itself are copied from the texture holding the CPU framebuffer.        */
+/* Needs OpenGL 3.0 (integer textures); the GL context must be current.  */
+
+/* Returns 0 if the compositor could not be set up (format = pixel format */
+/* the framebuffer is uploaded with, as given to glTexSubImage2D)         */
+int Video_Gpu_Init(unsigned int format);
+void Video_Gpu_Close();
+
+/* Draws the frame into tex_target (VIDEO_WIDTH x 448, as tex_frame) */
+void Video_Gpu_Composite(unsigned int tex_frame, unsigned int tex_target);
+
+#endif
@@ -4,7 +4,8 @@
 
 int Backend_Video_Close() { return 1; }
 int Backend_Video_Init() {
-  bitmap.data = (unsigned char *)malloc(bitmap.pitch * bitmap.height);
+  // Room for the doubled-up 2P (interlaced) output
+  bitmap.data = (unsigned char *)calloc((VIDEO_HEIGHT * 2) + 1, bitmap.pitch);
   return 1;
 }
 int Backend_Video_SetFullscreen(int arg_fullscreen) { return 1; }
@@ -58,7 +58,7 @@ int Backend_Video_Update() {
     sdl_video.surf_screen  = SDL_GetVideoSurface();
 
     /* source bitmap */
-    sdl_video.srect.w = 400;
+    sdl_video.srect.w = VIDEO_WIDTH;
     sdl_video.srect.h = 240;
     sdl_video.srect.x = 0;
     sdl_video.srect.y = 0;
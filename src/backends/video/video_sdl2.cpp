@@ -8,30 +8,35 @@
 #include <SDL2/SDL_image.h>
 #include "shared.h"
 
+// Texture format matches the core's output pixels exactly (see PIXEL() in
+// vdp_render.h), so frames can be uploaded without any conversion.
 #if defined(USE_8BPP_RENDERING)
-  #define SURFACE_FORMAT SDL_PIXELFORMAT_RGB332
+  #define TEXTURE_FORMAT SDL_PIXELFORMAT_RGB332
 #elif defined(USE_15BPP_RENDERING)
-  #define SURFACE_FORMAT SDL_PIXELFORMAT_RGB555
+  #define TEXTURE_FORMAT SDL_PIXELFORMAT_ARGB1555
 #elif defined(USE_16BPP_RENDERING)
-  #define SURFACE_FORMAT SDL_PIXELFORMAT_RGB565
+  #define TEXTURE_FORMAT SDL_PIXELFORMAT_RGB565
+#elif defined(USE_32BPP_RENDERING) && defined(USE_ABGR)
+  #define TEXTURE_FORMAT SDL_PIXELFORMAT_ABGR8888
 #elif defined(USE_32BPP_RENDERING)
-  #define SURFACE_FORMAT SDL_PIXELFORMAT_RGB888
+  #define TEXTURE_FORMAT SDL_PIXELFORMAT_ARGB8888
 #endif
 
+// Bitmap rows: 2P (interlaced) output writes both fields of every line, so
+// the buffer holds two screens, plus one spare row
+#define BITMAP_HEIGHT ((VIDEO_HEIGHT * 2) + 1)
+
 SDL_Window* sdl_window;
 SDL_Renderer* sdl_renderer;
 SDL_Surface* sdl_winsurf;
-SDL_Surface* sdl_bitmap;
 SDL_Texture* sdl_texture;
+uint8 *sdl_bitmap;
 SDL_Rect rect_source;
 SDL_Rect rect_dest;
 Uint16 screen_width;
 Uint16 screen_height;
 int fullscreen;
 
-Uint32 tex_fmt_id;
-SDL_PixelFormat *dst_fmt;
-
 int SDL_OnResize(void* data, SDL_Event* event) {
   if (
     event->type == SDL_WINDOWEVENT &&
@@ -42,28 +47,23 @@ int SDL_OnResize(void* data, SDL_Event* event) {
 
 void Init_Bitmap() {
   if (sdl_texture != NULL) SDL_DestroyTexture(sdl_texture);
-  if (sdl_bitmap != NULL) SDL_FreeSurface(sdl_bitmap);
+  if (sdl_bitmap != NULL) SDL_free(sdl_bitmap);
 
-  sdl_bitmap = SDL_CreateRGBSurfaceWithFormat(
-    0,
-    VIDEO_WIDTH,
-    (VIDEO_HEIGHT * 2) + 1, // idk but it stops a segfault in 2p
-    SDL_BITSPERPIXEL(SURFACE_FORMAT),
-    SURFACE_FORMAT
-  );
+  // The core renders straight into this buffer, which is already in the
+  // texture's pixel format. It persists between frames (unlike locked texture
+  // memory) since the core may clear or read it back outside of a frame.
+  sdl_bitmap = (uint8 *)SDL_calloc(BITMAP_HEIGHT, bitmap.pitch);
 
   sdl_texture = SDL_CreateTexture(
     sdl_renderer, 
-    SURFACE_FORMAT, 
+    TEXTURE_FORMAT, 
     SDL_TEXTUREACCESS_STREAMING,
     VIDEO_WIDTH,
-    (VIDEO_HEIGHT * 2) + 1
+    BITMAP_HEIGHT
   );
   SDL_SetTextureBlendMode(sdl_texture, SDL_BLENDMODE_BLEND);
 
-  SDL_LockSurface(sdl_bitmap);
-  bitmap.data = (unsigned char *)sdl_bitmap->pixels;
-  SDL_UnlockSurface(sdl_bitmap);
+  bitmap.data = (unsigned char *)sdl_bitmap;
 }
 
 int Backend_Video_Init() {
@@ -106,9 +106,6 @@ int Backend_Video_Init() {
   SDL_ShowCursor(0);
   SDL_AddEventWatch(SDL_OnResize, sdl_window);
 
-  SDL_QueryTexture(sdl_texture, &tex_fmt_id, NULL, NULL, NULL);
-  dst_fmt = SDL_AllocFormat(tex_fmt_id);
-
   return 1;
 }
 
@@ -181,24 +178,29 @@ void Update_Viewport() {
 }
 
 void Update_Texture() {
-  /* Set up a destination surface for the texture update */
-  SDL_LockSurface(sdl_bitmap);
-  SDL_Surface *temp = SDL_ConvertSurface(sdl_bitmap, dst_fmt, 0);
-  SDL_UnlockSurface(sdl_bitmap);
-
-  Uint32 key_color = SDL_MapRGB(
-    temp->format,
-    0xFF, 0x00, 0xFF
-  );
-
-  // "Green screen" the image
-  for (int i = 0; i < temp->w * temp->h; i++) {
-    if (((Uint32*)temp->pixels)[i] != key_color) continue;
-    ((Uint32*)temp->pixels)[i] &= 0x00FFFFFF; 
+  // Only upload the rows the core actually rendered this frame
+  // (rect_source already covers the 2P half when it is in use)
+  SDL_Rect rect_update = rect_source;
+  if (rect_update.h > BITMAP_HEIGHT) rect_update.h = BITMAP_HEIGHT;
+
+  // Rows the core did not rewrite are already in the texture
+  if (video_dirty_count >= 0) {
+    for (int i = 0; i < video_dirty_count; i++) {
+      SDL_Rect rect_dirty = rect_update;
+      rect_dirty.y = video_dirty[i][0];
+      rect_dirty.h = video_dirty[i][1];
+      if (rect_dirty.y >= BITMAP_HEIGHT) break;
+      if ((rect_dirty.y + rect_dirty.h) > BITMAP_HEIGHT) rect_dirty.h = BITMAP_HEIGHT - rect_dirty.y;
+
+      SDL_UpdateTexture(sdl_texture, &rect_dirty, video_frame + (rect_dirty.y * bitmap.pitch), bitmap.pitch);
+    }
+    return;
   }
 
-  SDL_UpdateTexture(sdl_texture, NULL, temp->pixels, temp->pitch);
-  SDL_FreeSurface(temp);
+  // While the BG layers are disabled, the core already outputs the backdrop
+  // as a transparent key pixel, so the frame can be uploaded as-is
+
+  SDL_UpdateTexture(sdl_texture, &rect_update, video_frame, bitmap.pitch);
 }
 
 void Update_Renderer() {
@@ -236,9 +238,8 @@ int Backend_Video_Present() {
 }
 
 int Backend_Video_Close() {
-  SDL_FreeFormat(dst_fmt);
   SDL_DestroyTexture(sdl_texture);
-  SDL_FreeSurface(sdl_bitmap);
+  SDL_free(sdl_bitmap);
   SDL_DestroyWindow(sdl_window);
   SDL_Quit();
 
@@ -0,0 +1,357 @@
+/****************************************************************************
+ *  Headless benchmark
+ *
+ *  Loads a ROM (and optional IPS patch), then runs a fixed number of frames
+ *  as fast as possible with the null backends and no frame pacing. Prints
+ *  throughput, frame time percentiles and how frame time splits between
+ *  emulation (CPUs + VDP rendering) and audio mixing, so performance
+ *  regressions can be caught without a window or audio device. Builds with
+ *  PROFILER=1 also print the average time of each profiler section, and
+ *  MULTI_INSTANCE=1 builds can run several copies of the ROM side by side
+ *  on the parallel runner to measure how it scales. PARALLEL_RENDER=1 builds
+ *  can render each frame on several threads.
+ *
+ ****************************************************************************/
+
+#include <time.h>
+
+#include "shared.h"
+#include "sms_ntsc.h"
+#include "md_ntsc.h"
+#include "config.h"
+#include "argparse.h"
+#include "runner.h"
+#include "renderpool.h"
+
+#include "backends/sound/sound_base.h"
+#include "backends/video/video_base.h"
+#include "backends/input/input_base.h"
+
+#define BENCH_FRAMES  3600
+#define BENCH_WARMUP  60
+
+/* Frontend globals normally provided by main.cpp */
+short soundframe[SOUND_SAMPLES_SIZE];
+int option_mirrormode = 0;
+int option_scaling = 0;
+unsigned char *video_frame;
+int log_error = 0;
+int debug_on = 0;
+int running = 1;
+md_ntsc_t *md_ntsc;
+sms_ntsc_t *sms_ntsc;
+
+static const char *const bench_usage[] = {
+  "bench [options] [rom]",
+  NULL,
+};
+
+static double bench_now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+static double bench_percentile(const double *sorted, int count, int percent)
+{
+  int index = ((count - 1) * percent) / 100;
+  return sorted[index];
+}
+
+static void bench_frame(void)
+{
+  if (system_hw == SYSTEM_MCD) system_frame_scd(0);
+  else if ((system_hw & SYSTEM_PBC) == SYSTEM_MD) system_frame_gen(0);
+  else system_frame_sms(0);
+}
+
+static void bench_bitmap(void)
+{
+  memset(&bitmap, 0, sizeof(t_bitmap));
+  bitmap.width        = VIDEO_WIDTH;
+  bitmap.height       = VIDEO_HEIGHT;
+#if defined(USE_8BPP_RENDERING)
+  bitmap.pitch        = (bitmap.width * 1);
+#elif defined(USE_15BPP_RENDERING)
+  bitmap.pitch        = (bitmap.width * 2);
+#elif defined(USE_16BPP_RENDERING)
+  bitmap.pitch        = (bitmap.width * 2);
+#elif defined(USE_32BPP_RENDERING)
+  bitmap.pitch        = (bitmap.width * 4);
+#endif
+}
+
+static void bench_print_times(double *frame_ms, int frames, double total_ms)
+{
+  qsort(frame_ms, frames, sizeof(double), bench_compare);
+
+  printf("ms/frame:  avg %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+    total_ms / frames,
+    bench_percentile(frame_ms, frames, 50),
+    bench_percentile(frame_ms, frames, 90),
+    bench_percentile(frame_ms, frames, 99),
+    frame_ms[frames - 1]);
+}
+
+#ifdef USE_CORE_CONTEXT
+static int bench_multi(char *rom_path, char *diff_path, int instances, int threads, int frames, int warmup)
+{
+  t_context *ctx[RUNNER_MAX_INSTANCES];
+  int i;
+
+  if ((instances < 1) || (instances > RUNNER_MAX_INSTANCES))
+  {
+    fprintf(stderr, "Between 1 and %d instances can be run.\n", RUNNER_MAX_INSTANCES);
+    return 1;
+  }
+
+  for (i = 0; i < instances; i++)
+  {
+    ctx[i] = context_create();
+    if (ctx[i] == NULL)
+    {
+      fprintf(stderr, "Can't allocate instance %d.\n", i);
+      return 1;
+    }
+
+    context_select(ctx[i]);
+    bench_bitmap();
+    bitmap.data = (uint8 *)calloc((VIDEO_HEIGHT * 2) + 1, bitmap.pitch);
+    bitmap.viewport.changed = 3;
+
+    if ((bitmap.data == NULL) || !load_rom(rom_path, diff_path))
+    {
+      fprintf(stderr, "Error loading file `%s'.\n", rom_path);
+      return 1;
+    }
+
+    audio_init(SOUND_FREQUENCY, 0);
+    system_init();
+    system_reset();
+
+    context_select(NULL);
+  }
+
+  threads = runner_init(threads);
+  for (i = 0; i < instances; i++)
+    runner_add(ctx[i]);
+
+  double *frame_ms = (double *)malloc(frames * sizeof(double));
+  if (frame_ms == NULL)
+  {
+    fprintf(stderr, "Can't allocate %d frame timings.\n", frames);
+    return 1;
+  }
+
+  for (i = 0; i < warmup; i++)
+    runner_frame();
+
+  double start_ms = bench_now_ms();
+
+  for (i = 0; i < frames; i++)
+  {
+    double t0 = bench_now_ms();
+    runner_frame();
+    frame_ms[i] = bench_now_ms() - t0;
+  }
+
+  double total_ms = bench_now_ms() - start_ms;
+  double fps = (frames * 1000.0) / total_ms;
+
+  printf("ROM:       %s\n", rom_path);
+  printf("Instances: %d on %d thread(s)\n", instances, threads);
+  printf("Frames:    %d (+%d warmup)\n", frames, warmup);
+  printf("Total:     %.3f s\n", total_ms / 1000.0);
+  printf("Speed:     %.2f fps per instance (%.2f instance frames/s)\n", fps, fps * instances);
+  bench_print_times(frame_ms, frames, total_ms);
+  for (i = 0; i < instances; i++)
+    printf("  instance %-2d %8.3f ms/frame\n", i, runner_cost(i));
+
+  free(frame_ms);
+  runner_close();
+
+  for (i = 0; i < instances; i++)
+  {
+    context_select(ctx[i]);
+    free(bitmap.data);
+    context_destroy(ctx[i]);
+  }
+
+  return 0;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+  char *rom_path = NULL;
+  char *diff_path = NULL;
+  char *config_path = NULL;
+  int frames = BENCH_FRAMES;
+  int warmup = BENCH_WARMUP;
+#ifdef ENABLE_PROFILER
+  char *csv_path = NULL;
+#endif
+#ifdef USE_CORE_CONTEXT
+  int instances = 1;
+  int threads = 1;
+#endif
+#ifdef USE_PARALLEL_RENDER
+  int render_threads = 1;
+#endif
+
+  struct argparse_option options[] = {
+    OPT_HELP(),
+    OPT_STRING('r', "rom", &rom_path, "Path to ROM file"),
+    OPT_STRING('p', "patch", &diff_path, "Path to IPS patch file"),
+    OPT_STRING('c', "config", &config_path, "Path to config file (defaults are used otherwise)"),
+    OPT_INTEGER('n', "frames", &frames, "Number of frames to time"),
+    OPT_INTEGER('w', "warmup", &warmup, "Number of untimed frames to run first"),
+#ifdef ENABLE_PROFILER
+    OPT_STRING(0, "csv", &csv_path, "Write per-frame profiler sections to this CSV file"),
+#endif
+#ifdef USE_CORE_CONTEXT
+    OPT_INTEGER('i', "instances", &instances, "Number of consoles to run side by side"),
+    OPT_INTEGER('t', "threads", &threads, "Worker threads for the consoles (0: one per CPU core)"),
+#endif
+#ifdef USE_PARALLEL_RENDER
+    OPT_INTEGER('R', "render-threads", &render_threads, "Threads rendering each frame (0: one per CPU core)"),
+#endif
+    OPT_END(),
+  };
+  struct argparse argparse;
+  argparse_init(&argparse, options, bench_usage, 0);
+  argparse_describe(&argparse, "\nGPGX Widescreen benchmark", "");
+  argc = argparse_parse(&argparse, argc, (const char **)argv);
+
+  if ((rom_path == NULL) && (argc > 0))
+    rom_path = (char *)argv[0];
+
+  if ((rom_path == NULL) || (frames <= 0) || (warmup < 0))
+  {
+    argparse_usage(&argparse);
+    return 1;
+  }
+
+  /* set default config (a missing file falls back to built-in defaults) */
+  error_init();
+  config_load(config_path ? config_path : "");
+
+#ifdef USE_CORE_CONTEXT
+  if ((instances != 1) || (threads != 1))
+  {
+    int result = bench_multi(rom_path, diff_path, instances, threads, frames, warmup);
+    error_shutdown();
+    return result;
+  }
+#endif
+
+  if (!load_rom(rom_path, diff_path))
+  {
+    fprintf(stderr, "Error loading file `%s'.\n", rom_path);
+    return 1;
+  }
+
+  /* initialize Genesis virtual system */
+  bench_bitmap();
+  Backend_Video_Init();
+  Backend_Input_Init();
+  Backend_Sound_Init();
+
+  bitmap.viewport.changed = 3;
+
+  audio_init(SOUND_FREQUENCY, 0);
+  system_init();
+  system_reset();
+
+#ifdef USE_PARALLEL_RENDER
+  render_threads = render_pool_init(render_threads);
+#endif
+
+  double *frame_ms = (double *)malloc(frames * sizeof(double));
+  if (frame_ms == NULL)
+  {
+    fprintf(stderr, "Can't allocate %d frame timings.\n", frames);
+    return 1;
+  }
+
+  for (int i = 0; i < warmup; i++)
+  {
+    bench_frame();
+    audio_update(soundframe);
+  }
+
+  double emulation_ms = 0;
+  double audio_ms = 0;
+
+#ifdef ENABLE_PROFILER
+  profiler_reset();
+#endif
+
+  double start_ms = bench_now_ms();
+
+  for (int i = 0; i < frames; i++)
+  {
+    double t0 = bench_now_ms();
+    bench_frame();
+    double t1 = bench_now_ms();
+    audio_update(soundframe);
+    double t2 = bench_now_ms();
+
+    emulation_ms += t1 - t0;
+    audio_ms += t2 - t1;
+    frame_ms[i] = t2 - t0;
+
+#ifdef ENABLE_PROFILER
+    profiler_frame();
+#endif
+  }
+
+  double total_ms = bench_now_ms() - start_ms;
+
+  double native_fps = (double)system_clock / (MCYCLES_PER_LINE * (vdp_pal ? 313 : 262));
+  double fps = (frames * 1000.0) / total_ms;
+
+  printf("ROM:       %s\n", rominfo.international);
+  printf("Frames:    %d (+%d warmup)\n", frames, warmup);
+#ifdef USE_PARALLEL_RENDER
+  printf("Render:    %d thread(s)\n", render_threads);
+#endif
+  printf("Total:     %.3f s\n", total_ms / 1000.0);
+  printf("Speed:     %.2f fps (%.2fx realtime)\n", fps, fps / native_fps);
+  bench_print_times(frame_ms, frames, total_ms);
+  printf("Split:     emulation %.1f%%  audio %.1f%%\n",
+    (emulation_ms * 100.0) / (emulation_ms + audio_ms),
+    (audio_ms * 100.0) / (emulation_ms + audio_ms));
+
+#ifdef ENABLE_PROFILER
+  printf("Profile:   average us/frame over last %d frames\n", profiler_frames());
+  for (int s = 0; s < PROFILER_SECTIONS; s++)
+    printf("  %-16s %9.1f\n", profiler_section_name(s), profiler_average_us(s));
+
+  if (csv_path && !profiler_dump_csv(csv_path))
+    fprintf(stderr, "Can't write `%s'.\n", csv_path);
+#endif
+
+  free(frame_ms);
+
+#ifdef USE_PARALLEL_RENDER
+  render_pool_close();
+#endif
+
+  audio_shutdown();
+  error_shutdown();
+
+  Backend_Input_Close();
+  Backend_Sound_Close();
+  Backend_Video_Close();
+
+  return 0;
+}
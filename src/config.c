@@ -38,6 +38,13 @@ void config_legacy_update() {
 	SET_FROM_IF_EXISTS(config_system, "no_sprite_limit",		uint8,	json_boolean_value, config_legacy.no_sprite_limit);
 	SET_FROM_IF_EXISTS(config_system, "lcd",					uint8,	json_boolean_value, config_legacy.lcd);
 	SET_FROM_IF_EXISTS(config_system, "ntsc",					uint8,	json_boolean_value, config_legacy.ntsc);
+	SET_FROM_IF_EXISTS(config_system, "screen_width",			uint16,	json_integer_value, config_legacy.screen_width);
+	SET_FROM_IF_EXISTS(config_system, "gpu_render",				uint8,	json_boolean_value, config_legacy.gpu_render);
+
+	/* extra columns are split evenly between both sides of the 320 pixel screen */
+	if (config_legacy.screen_width < 320) config_legacy.screen_width = 320;
+	if (config_legacy.screen_width > SCREEN_WIDTH_MAX) config_legacy.screen_width = SCREEN_WIDTH_MAX;
+	config_legacy.screen_width &= ~1;
 }
 
 void config_legacy_set_defaults(void)
@@ -84,6 +91,8 @@ void config_legacy_set_defaults(void)
 	config_legacy.overscan = 0;       /* 3 = all borders (0 = no borders , 1 = vertical borders only, 2 = horizontal borders only) */
 	config_legacy.gg_extra = 0;       /* 1 = show extended Game Gear screen (256x192) */
 	config_legacy.render   = 1;       /* 1 = double resolution output (only when interlaced mode 2 is enabled) */
+	config_legacy.screen_width = 400; /* Mode 5 H40 width in pixels, 320 (4:3) up to SCREEN_WIDTH_MAX */
+	config_legacy.gpu_render = 0;     /* 1 = composite Mode 5 lines on the GPU (GPU_RENDER=1 builds with OpenGL 3.0) */
 
 	/* controllers options */
 	input.system[0]       = SYSTEM_GAMEPAD;
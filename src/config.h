@@ -61,6 +61,8 @@ typedef struct
   uint8 ntsc;
   uint8 lcd;
   uint8 render;
+  uint16 screen_width;
+  uint8 gpu_render;
   t_input_config input[MAX_INPUTS];
 } t_config;
 
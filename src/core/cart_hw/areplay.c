@@ -41,7 +41,7 @@
 #define TYPE_PRO1 0x12
 #define TYPE_PRO2 0x22
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 enabled;
   uint8 status;
@@ -253,6 +253,9 @@ void areplay_set_status(int status)
       }
     }
 
+    /* patched instructions must be decoded again */
+    m68k_predecode_flush();
+
     /* update status */
     action_replay.status = status;
   }
@@ -284,6 +287,7 @@ static void ar_write_regs(uint32 address, uint32 data)
 
     /* enable Cartridge ROM */
     m68k.memory_map[0].base = cart.rom;
+    m68k_memory_map_update();
   }
 }
 
@@ -293,6 +297,7 @@ static void ar_write_regs_2(uint32 address, uint32 data)
   if (((address & 0xff) == 0x78) && (data == 0xffff))
   {
     m68k.memory_map[0].base = cart.rom;
+    m68k_memory_map_update();
   }
 }
 
@@ -302,3 +307,9 @@ static void ar_write_ram_8(uint32 address, uint32 data)
   *(uint16 *)(action_replay.ram + (address & 0xfffe)) = (data | (data << 8));
 }
 
+#ifdef USE_CORE_CONTEXT
+void areplay_context_regions(void)
+{
+  CONTEXT_REGION(action_replay);
+}
+#endif
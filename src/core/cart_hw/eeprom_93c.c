@@ -45,7 +45,7 @@
 #define BIT_CS   (2)
 
 
-T_EEPROM_93C eeprom_93c;
+CONTEXT_LOCAL T_EEPROM_93C eeprom_93c;
 
 void eeprom_93c_init()
 {
@@ -247,3 +247,9 @@ unsigned char eeprom_93c_read(void)
   return ((eeprom_93c.cs << BIT_CS) | (eeprom_93c.data << BIT_DATA) | (1 << BIT_CLK));
 }
 
+#ifdef USE_CORE_CONTEXT
+void eeprom_93c_context_regions(void)
+{
+  CONTEXT_REGION(eeprom_93c);
+}
+#endif
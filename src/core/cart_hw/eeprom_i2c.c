@@ -156,7 +156,7 @@ static const T_I2C_GAME i2c_database[] =
   {"XXXXXXXX" , 0          , 0xDF39 , mapper_i2c_jcart_init       , NO_EEPROM     }, /* Pete Sampras Tennis 96 (Prototype ?) */
 };
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 sda;              /* current SDA line state */
   uint8 scl;              /* current SCL line state */
@@ -788,6 +788,8 @@ static void mapper_acclaim_32M_write16(uint32 address, uint32 data)
       zbank_memory_map[i].read   = mapper_i2c_generic_read8;
     }
   }
+
+  m68k_memory_map_update();
 }
 
 static void mapper_i2c_acclaim_32M_init(void)
@@ -888,3 +890,10 @@ static void mapper_i2c_jcart_init(void)
   eeprom_i2c.sda_in_bit  = 0;
   eeprom_i2c.sda_out_bit = 7;
 }
+
+#ifdef USE_CORE_CONTEXT
+void eeprom_i2c_context_regions(void)
+{
+  CONTEXT_REGION(eeprom_i2c);
+}
+#endif
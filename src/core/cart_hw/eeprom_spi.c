@@ -70,7 +70,7 @@ typedef struct
   T_STATE_SPI state;  /* current operation state */
 } T_EEPROM_SPI;
 
-static T_EEPROM_SPI spi_eeprom;
+static CONTEXT_LOCAL T_EEPROM_SPI spi_eeprom;
 
 void eeprom_spi_init()
 {
@@ -356,3 +356,9 @@ unsigned int eeprom_spi_read(unsigned int address)
   return (spi_eeprom.out << BIT_DATA);
 }
 
+#ifdef USE_CORE_CONTEXT
+void eeprom_spi_context_regions(void)
+{
+  CONTEXT_REGION(spi_eeprom);
+}
+#endif
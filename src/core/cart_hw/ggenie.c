@@ -41,7 +41,7 @@
 
 #include "shared.h"
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 enabled;
   uint8 *rom;
@@ -154,6 +154,9 @@ void ggenie_switch(int enable)
       }
     }
   }
+
+  /* patched instructions must be decoded again */
+  m68k_predecode_flush();
 }
 
 static unsigned int ggenie_read_byte(unsigned int address)
@@ -262,6 +265,8 @@ static void ggenie_write_regs(unsigned int offset, unsigned int data)
       m68k.memory_map[0].write8   = ggenie_write_byte;
       m68k.memory_map[0].write16  = ggenie_write_word;
     }
+
+    m68k_memory_map_update();
   }
 
   /* RESET register */
@@ -270,3 +275,10 @@ static void ggenie_write_regs(unsigned int offset, unsigned int data)
     ggenie.regs[1] |= 1;
   }
 }
+
+#ifdef USE_CORE_CONTEXT
+void ggenie_context_regions(void)
+{
+  CONTEXT_REGION(ggenie);
+}
+#endif
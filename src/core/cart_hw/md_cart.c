@@ -922,6 +922,8 @@ static void mapper_sega_w(uint32 data)
       zbank_memory_map[i].write   = zbank_unused_w;
     }
   }
+
+  m68k_memory_map_update();
 }
 
 /*
@@ -943,6 +945,8 @@ static void mapper_512k_w(uint32 address, uint32 data)
   {
     m68k.memory_map[address++].base = src + (i<<16);
   }
+
+  m68k_memory_map_update();
 }
 
 /*
@@ -1043,6 +1047,7 @@ static void mapper_sf001_w(uint32 address, uint32 data)
         zbank_memory_map[0x00].write  = m68k_unused_8_w;
       }
 
+      m68k_memory_map_update();
       return;
     }
 
@@ -1076,6 +1081,8 @@ static void mapper_sf002_w(uint32 address, uint32 data)
       m68k.memory_map[i].base = cart.rom + (i << 16);
     }
   }
+
+  m68k_memory_map_update();
 }
 
 /* 
@@ -1116,6 +1123,7 @@ static void mapper_sf004_w(uint32 address, uint32 data)
         }
       }
 
+      m68k_memory_map_update();
       return;
     }
 
@@ -1177,6 +1185,7 @@ static void mapper_sf004_w(uint32 address, uint32 data)
         zbank_memory_map[0x00].write = m68k_unused_8_w;
       }
 
+      m68k_memory_map_update();
       return;
     }
 
@@ -1202,6 +1211,7 @@ static void mapper_sf004_w(uint32 address, uint32 data)
         }
       }
 
+      m68k_memory_map_update();
       return;
     }
 
@@ -1247,6 +1257,7 @@ static void mapper_t5740_w(uint32 address, uint32 data)
       {
         m68k.memory_map[i].base = base + ((i & 0x07) << 16);
       }
+      m68k_memory_map_update();
       return;
     }
 
@@ -1258,6 +1269,7 @@ static void mapper_t5740_w(uint32 address, uint32 data)
       {
         m68k.memory_map[i].base = base + ((i & 0x07) << 16);
       }
+      m68k_memory_map_update();
       return;
     }
 
@@ -1269,6 +1281,7 @@ static void mapper_t5740_w(uint32 address, uint32 data)
       {
         m68k.memory_map[i].base = base + ((i & 0x07) << 16);
       }
+      m68k_memory_map_update();
       return;
     }
 
@@ -1314,11 +1327,13 @@ static void mapper_flashkit_w(uint32 address, uint32 data)
   {
     /* assume 'Auto Select' command */
     m68k.memory_map[0x0].read16 = mapper_flashkit_r;
+    m68k_memory_map_update();
   }
   else if (cart.hw.regs[0] == 4)
   {
     /* assume 'Read/Reset' command */
     m68k.memory_map[0x0].read16 = NULL;
+    m68k_memory_map_update();
 
     /* reset Bus Write counter */
     cart.hw.regs[0] = 0;
@@ -1372,6 +1387,7 @@ static void mapper_smw_64_w(uint32 address, uint32 data)
           {
             /* update selected ROM bank (upper 512K) mapped at $610000-$61ffff */
             m68k.memory_map[0x61].base = m68k.memory_map[0x69].base = cart.rom + 0x080000 + ((data & 0x1c) << 14);
+            m68k_memory_map_update();
             break;
           }
 
@@ -1436,6 +1452,7 @@ static void mapper_smw_64_w(uint32 address, uint32 data)
         {
           /* update selected ROM bank (upper 512K) mapped at $600000-$60ffff */
           m68k.memory_map[0x60].base = m68k.memory_map[0x68].base = cart.rom + 0x080000 + ((data & 0x1c) << 14);
+          m68k_memory_map_update();
         }
       }
       return;
@@ -1545,6 +1562,8 @@ static void mapper_realtec_w(uint32 address, uint32 data)
         {
           m68k.memory_map[i].base = &cart.rom[(base + (i % cart.hw.regs[2])) << 16];
         }
+
+        m68k_memory_map_update();
       }
       return;
     }
@@ -1566,6 +1585,9 @@ static void mapper_seganet_w(uint32 address, uint32 data)
         m68k.memory_map[i].write16  = m68k_unused_16_w;
         zbank_memory_map[i].write   = zbank_unused_w;
       }
+
+      /* ROM may have been written meanwhile */
+      m68k_predecode_flush();
     }
     else
     {
@@ -1576,7 +1598,12 @@ static void mapper_seganet_w(uint32 address, uint32 data)
         m68k.memory_map[i].write16  = NULL;
         zbank_memory_map[i].write   = NULL;
       }
+
+      /* ROM code can be modified from now on */
+      m68k_predecode_flush();
     }
+
+    m68k_memory_map_update();
   }
 }
 
@@ -1608,6 +1635,8 @@ static void mapper_32k_w(uint32 data)
       m68k.memory_map[i].base = &cart.rom[i << 16];
     }
   }
+
+  m68k_memory_map_update();
 }
 
 /* 
@@ -1634,6 +1663,8 @@ static void mapper_64k_w(uint32 data)
       m68k.memory_map[i].base = &cart.rom[(i & 0xf) << 16];
     }
   }
+
+  m68k_memory_map_update();
 }
 
 /* 
@@ -1648,6 +1679,8 @@ static void mapper_64k_multi_w(uint32 address)
   {
     m68k.memory_map[i].base = &cart.rom[((address++) & 0x3f) << 16];
   }
+
+  m68k_memory_map_update();
 }
 
 /*
@@ -1664,6 +1697,7 @@ static uint32 mapper_radica_r(uint32 address)
     m68k.memory_map[i].base = &cart.rom[((address++)& 0x3f)<< 16];
   }
 
+  m68k_memory_map_update();
   return 0xffff;
 }
 
@@ -360,11 +360,11 @@ static const rominfo_t game_list[] =
 };
 
 /* Cartridge & BIOS ROM hardware */
-static romhw_t cart_rom;
-static romhw_t bios_rom;
+static CONTEXT_LOCAL romhw_t cart_rom;
+static CONTEXT_LOCAL romhw_t bios_rom;
 
 /* Current slot */
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 *rom;
   uint8 *fcr;
@@ -757,12 +757,12 @@ int sms_cart_context_save(uint8 *state)
   if ((cart_rom.mapper == MAPPER_RAM_8K) || (cart_rom.mapper == MAPPER_RAM_8K_EXT1))
   {
     /* 8KB extra RAM */
-    save_param(work_ram + 0x2000, 0x2000);
+    bufferptr += state_save_pages(&state[bufferptr], STATE_PAGES_WRAM + 2, work_ram + 0x2000, 0x2000);
   }
   else if (cart_rom.mapper == MAPPER_RAM_2K)
   {
     /* 2KB extra RAM */
-    save_param(work_ram + 0x2000, 0x800);
+    bufferptr += state_save_pages(&state[bufferptr], STATE_PAGES_WRAM + 2, work_ram + 0x2000, 0x800);
   }
 
   return bufferptr;
@@ -822,12 +822,12 @@ int sms_cart_context_load(uint8 *state)
   if ((cart_rom.mapper == MAPPER_RAM_8K) || (cart_rom.mapper == MAPPER_RAM_8K_EXT1))
   {
     /* 8KB extra RAM */
-    load_param(work_ram + 0x2000, 0x2000);
+    bufferptr += state_load_pages(&state[bufferptr], STATE_PAGES_WRAM + 2, work_ram + 0x2000, 0x2000);
   }
   else if (cart_rom.mapper == MAPPER_RAM_2K)
   {
     /* 2KB extra RAM */
-    load_param(work_ram + 0x2000, 0x800);
+    bufferptr += state_load_pages(&state[bufferptr], STATE_PAGES_WRAM + 2, work_ram + 0x2000, 0x800);
   }
 
   return bufferptr;
@@ -1289,6 +1289,7 @@ static void mapper_32k_w(unsigned char data)
 static void write_mapper_none(unsigned int address, unsigned char data)
 {
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_sega(unsigned int address, unsigned char data)
@@ -1299,6 +1300,7 @@ static void write_mapper_sega(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_codies(unsigned int address, unsigned char data)
@@ -1322,6 +1324,7 @@ static void write_mapper_codies(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_multi_16k(unsigned int address, unsigned char data)
@@ -1345,6 +1348,7 @@ static void write_mapper_multi_16k(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_multi_32k(unsigned int address, unsigned char data)
@@ -1355,6 +1359,7 @@ static void write_mapper_multi_32k(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_korea(unsigned int address, unsigned char data)
@@ -1366,6 +1371,7 @@ static void write_mapper_korea(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_msx(unsigned int address, unsigned char data)
@@ -1377,6 +1383,7 @@ static void write_mapper_msx(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_korea_8k(unsigned int address, unsigned char data)
@@ -1417,6 +1424,7 @@ static void write_mapper_korea_8k(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_korea_16k(unsigned int address, unsigned char data)
@@ -1440,6 +1448,7 @@ static void write_mapper_korea_16k(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_93c46(unsigned int address, unsigned char data)
@@ -1471,6 +1480,7 @@ static void write_mapper_93c46(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static void write_mapper_terebi(unsigned int address, unsigned char data)
@@ -1482,6 +1492,7 @@ static void write_mapper_terebi(unsigned int address, unsigned char data)
   }
 
   z80_writemap[address >> 10][address & 0x03FF] = data;
+  STATE_DIRTY_PTR(&z80_writemap[address >> 10][address & 0x03FF]);
 }
 
 static unsigned char read_mapper_93c46(unsigned int address)
@@ -1533,3 +1544,13 @@ static unsigned char read_mapper_default(unsigned int address)
 {
   return z80_readmap[address >> 10][address & 0x03FF];
 }
+
+#ifdef USE_CORE_CONTEXT
+void sms_cart_context_regions(void)
+{
+  CONTEXT_REGION(cart_rom);
+  CONTEXT_REGION(bios_rom);
+  CONTEXT_REGION(slot);
+  CONTEXT_POINTERS(slot.fcr, 1, sizeof(slot.fcr));
+}
+#endif
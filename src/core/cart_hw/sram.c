@@ -38,7 +38,7 @@
 
 #include "shared.h"
 
-T_SRAM sram;
+CONTEXT_LOCAL T_SRAM sram;
 
 /****************************************************************************
  * A quick guide to external RAM on the Genesis
@@ -226,3 +226,10 @@ void sram_write_word(unsigned int address, unsigned int data)
 {
   WRITE_WORD(sram.sram, address & 0xfffe, data);
 }
+
+#ifdef USE_CORE_CONTEXT
+void sram_context_regions(void)
+{
+  CONTEXT_REGION(sram);
+}
+#endif
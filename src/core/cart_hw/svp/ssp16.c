@@ -339,9 +339,9 @@
 }
 
 
-static ssp1601_t *ssp = NULL;
-static unsigned short *PC;
-static int g_cycles;
+static CONTEXT_LOCAL ssp1601_t *ssp = NULL;
+static CONTEXT_LOCAL unsigned short *PC;
+static CONTEXT_LOCAL int g_cycles;
 
 #ifdef USE_DEBUGGER
 static int running = 0;
@@ -1328,3 +1328,11 @@ void ssp1601_run(int cycles)
 #endif
 }
 
+#ifdef USE_CORE_CONTEXT
+void ssp16_context_regions(void)
+{
+  CONTEXT_REGION(ssp);
+  CONTEXT_REGION(PC);
+  CONTEXT_REGION(g_cycles);
+}
+#endif
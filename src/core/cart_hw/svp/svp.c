@@ -12,7 +12,7 @@
 
 #include "shared.h"
 
-svp_t *svp;
+CONTEXT_LOCAL svp_t *svp;
 
 static void svp_write_dram(uint32 address, uint32 data)
 {
@@ -83,3 +83,9 @@ void svp_reset(void)
   ssp1601_reset(&svp->ssp1601);
 }
 
+#ifdef USE_CORE_CONTEXT
+void svp_context_regions(void)
+{
+  CONTEXT_REGION(svp);
+}
+#endif
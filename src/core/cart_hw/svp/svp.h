@@ -22,7 +22,7 @@ typedef struct {
   ssp1601_t ssp1601;
 } svp_t;
 
-extern svp_t *svp;
+extern CONTEXT_LOCAL svp_t *svp;
 
 extern void svp_init(void);
 extern void svp_reset(void);
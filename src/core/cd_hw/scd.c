@@ -754,6 +754,9 @@ INLINE void word_ram_switch(uint8 mode)
       s68k.memory_map[i].write16 = s68k_unused_16_w;
     }
   }
+
+  m68k_memory_map_update();
+  s68k_memory_map_update();
 }
 
 static void scd_write_byte(unsigned int address, unsigned int data)
@@ -901,6 +904,9 @@ static void scd_write_byte(unsigned int address, unsigned int data)
             }
           }
 
+          m68k_memory_map_update();
+          s68k_memory_map_update();
+
           /* clear DMNA bit (swap completed) */
           scd.regs[0x02 >> 1].byte.l = (scd.regs[0x02 >> 1].byte.l & ~0x1f) | (data & 0x1d);
           return;
@@ -1179,6 +1185,9 @@ static void scd_write_word(unsigned int address, unsigned int data)
             }
           }
 
+          m68k_memory_map_update();
+          s68k_memory_map_update();
+
           /* clear DMNA bit (swap completed) */
           scd.regs[0x03>>1].byte.l = (scd.regs[0x03>>1].byte.l & ~0x1f) | (data & 0x1d);
           return;
@@ -0,0 +1,282 @@
+/***************************************************************************************
+ *  Genesis Plus GX
+ *  Emulator instance contexts
+ *
+ *  See context.h
+ *
+ ****************************************************************************************/
+
+#include "shared.h"
+
+#ifdef USE_CORE_CONTEXT
+
+#ifndef USE_DYNAMIC_ALLOC
+#error "USE_CORE_CONTEXT requires USE_DYNAMIC_ALLOC"
+#endif
+
+#define CONTEXT_MAX_REGIONS   256
+#define CONTEXT_MAX_POINTERS  32
+
+typedef struct
+{
+  uint8 *base;
+  size_t size;
+} t_context_region;
+
+typedef struct
+{
+  uint8 *first;
+  int count;
+  size_t stride;
+} t_context_pointers;
+
+struct t_context
+{
+  uint8 *state;                       /* private copy of all registered regions */
+  const void *owner;                  /* region table of the thread that last saved it */
+  uint8 *base[CONTEXT_MAX_REGIONS];   /* where each region lived in that thread */
+  uint8 *low, *high;                  /* bounds of the above */
+};
+
+/* Registered state, as seen from the calling thread */
+static CONTEXT_LOCAL t_context_region regions[CONTEXT_MAX_REGIONS];
+static CONTEXT_LOCAL int region_count;
+static CONTEXT_LOCAL t_context_pointers pointers[CONTEXT_MAX_POINTERS];
+static CONTEXT_LOCAL int pointer_count;
+static CONTEXT_LOCAL t_context *current;
+
+/* Same layout in every thread */
+static size_t state_size;
+
+/* State of all regions before the first context was created */
+static uint8 *power_on_state;
+
+void context_region(void *base, size_t size)
+{
+  if (region_count == CONTEXT_MAX_REGIONS)
+  {
+    fprintf(stderr, "context: too many state regions\n");
+    abort();
+  }
+
+  regions[region_count].base = (uint8 *)base;
+  regions[region_count].size = size;
+  region_count++;
+}
+
+void context_pointers(void *first, int count, size_t stride)
+{
+  if (pointer_count == CONTEXT_MAX_POINTERS)
+  {
+    fprintf(stderr, "context: too many state pointers\n");
+    abort();
+  }
+
+  pointers[pointer_count].first = (uint8 *)first;
+  pointers[pointer_count].count = count;
+  pointers[pointer_count].stride = stride;
+  pointer_count++;
+}
+
+static void context_register(void)
+{
+  int i;
+
+  areplay_context_regions();
+  eeprom_93c_context_regions();
+  eeprom_i2c_context_regions();
+  eeprom_spi_context_regions();
+  ggenie_context_regions();
+  sms_cart_context_regions();
+  sram_context_regions();
+  state_context_regions();
+  ssp16_context_regions();
+  svp_context_regions();
+  genesis_context_regions();
+  activator_context_regions();
+  gamepad_context_regions();
+  graphic_board_context_regions();
+  input_context_regions();
+  lightgun_context_regions();
+  mouse_context_regions();
+  paddle_context_regions();
+  sportspad_context_regions();
+  teamplayer_context_regions();
+  terebi_oekaki_context_regions();
+  xe_1ap_context_regions();
+  io_ctrl_context_regions();
+  loadrom_context_regions();
+  m68k_context_regions();
+  s68k_context_regions();
+  memz80_context_regions();
+  psg_context_regions();
+  sound_context_regions();
+  ym2413_context_regions();
+  ym2612_context_regions();
+  system_context_regions();
+  vdp_ctrl_context_regions();
+  vdp_render_context_regions();
+  z80_context_regions();
+
+  if (!state_size)
+  {
+    for (i = 0; i < region_count; i++)
+      state_size += regions[i].size;
+  }
+}
+
+static void context_save(t_context *ctx)
+{
+  uint8 *state = ctx->state;
+  int i;
+
+  for (i = 0; i < region_count; i++)
+  {
+    memcpy(state, regions[i].base, regions[i].size);
+    state += regions[i].size;
+  }
+
+  /* remember where the saved pointers were pointing to */
+  if (ctx->owner != regions)
+  {
+    ctx->owner = regions;
+    ctx->low = regions[0].base;
+    ctx->high = regions[0].base + regions[0].size;
+    for (i = 0; i < region_count; i++)
+    {
+      ctx->base[i] = regions[i].base;
+      if (regions[i].base < ctx->low) ctx->low = regions[i].base;
+      if (regions[i].base + regions[i].size > ctx->high) ctx->high = regions[i].base + regions[i].size;
+    }
+  }
+}
+
+static void context_relocate(t_context *ctx)
+{
+  int i, j, k;
+
+  for (i = 0; i < pointer_count; i++)
+  {
+    uint8 *ptr = pointers[i].first;
+
+    for (j = 0; j < pointers[i].count; j++, ptr += pointers[i].stride)
+    {
+      uint8 *value = *(uint8 **)ptr;
+
+      /* pointers to cartridge memory or constant tables are left untouched */
+      if (!value || (value < ctx->low) || (value > ctx->high)) continue;
+
+      for (k = 0; k < region_count; k++)
+      {
+        if ((value >= ctx->base[k]) && (value <= ctx->base[k] + regions[k].size))
+        {
+          *(uint8 **)ptr = regions[k].base + (value - ctx->base[k]);
+          break;
+        }
+      }
+    }
+  }
+}
+
+static void context_load(t_context *ctx)
+{
+  const uint8 *state = ctx->state;
+  int i;
+
+  for (i = 0; i < region_count; i++)
+  {
+    memcpy(regions[i].base, state, regions[i].size);
+    state += regions[i].size;
+  }
+
+  /* state was saved by another thread */
+  if (ctx->owner && (ctx->owner != regions))
+    context_relocate(ctx);
+}
+
+t_context *context_create(void)
+{
+  t_context *ctx;
+
+  if (!region_count)
+    context_register();
+
+  ctx = (t_context *)calloc(1, sizeof(t_context));
+  if (!ctx) return NULL;
+
+  ctx->state = (uint8 *)malloc(state_size);
+  if (!ctx->state)
+  {
+    free(ctx);
+    return NULL;
+  }
+
+  if (!power_on_state)
+  {
+    power_on_state = (uint8 *)malloc(state_size);
+    if (!power_on_state)
+    {
+      free(ctx->state);
+      free(ctx);
+      return NULL;
+    }
+
+    context_save(ctx);
+    memcpy(power_on_state, ctx->state, state_size);
+  }
+  else
+  {
+    memcpy(ctx->state, power_on_state, state_size);
+    ctx->owner = NULL;
+  }
+
+  return ctx;
+}
+
+void context_select(t_context *ctx)
+{
+  if (!region_count)
+    context_register();
+
+  if (ctx == current) return;
+
+  if (current)
+    context_save(current);
+
+  if (ctx)
+    context_load(ctx);
+
+  current = ctx;
+}
+
+void context_destroy(t_context *ctx)
+{
+  if (!ctx) return;
+
+  /* release what the instance allocated while it ran */
+  context_select(ctx);
+  audio_shutdown();
+  if (ext)
+  {
+    if (system_hw == SYSTEM_MCD)
+      cdd_unload();
+    free(ext);
+    ext = NULL;
+  }
+
+  /* leave power-on state behind, owned by no context */
+  memcpy(ctx->state, power_on_state, state_size);
+  ctx->owner = regions;
+  context_load(ctx);
+  current = NULL;
+
+  free(ctx->state);
+  free(ctx);
+}
+
+t_context *context_current(void)
+{
+  return current;
+}
+
+#endif /* USE_CORE_CONTEXT */
@@ -0,0 +1,113 @@
+/***************************************************************************************
+ *  Genesis Plus GX
+ *  Emulator instance contexts
+ *
+ *  USE_CORE_CONTEXT should be defined in a makefile to enable this functionality
+ *  (it also requires USE_DYNAMIC_ALLOC, see MULTI_INSTANCE=1)
+ *
+ *  The core keeps its state in globals. With contexts enabled, every module lists
+ *  the globals (and file statics) holding mutable emulator state, and a context owns
+ *  one private copy of all of them. Selecting a context swaps its copy in, so the
+ *  usual load_rom / system_init / system_frame_* calls then run that console. The
+ *  cartridge & CD hardware block is allocated per context and only its pointer is
+ *  swapped. Lookup tables filled at init (renderer LUTs, CPU flag tables, YM2612 &
+ *  YM2413 tables) are not listed and stay shared by all instances.
+ *
+ *  Listed state is also thread-local (CONTEXT_LOCAL), so each thread has its own
+ *  selected context and several consoles can run at once. A context may move to
+ *  another thread once released with context_select(NULL): memory map pointers
+ *  into per-instance arrays (work RAM, Z80 RAM, BOOT ROM...) are then rebased.
+ *
+ *  Selecting a context copies about 1 MB each way (VRAM and pattern cache included),
+ *  so switch once per frame rather than in the middle of one.
+ *
+ ****************************************************************************************/
+
+#ifndef _CONTEXT_H_
+#define _CONTEXT_H_
+
+/* Storage class of per-instance state */
+#if !defined(USE_CORE_CONTEXT)
+#define CONTEXT_LOCAL
+#elif defined(_MSC_VER)
+#define CONTEXT_LOCAL __declspec(thread)
+#else
+#define CONTEXT_LOCAL __thread
+#endif
+
+#ifdef USE_CORE_CONTEXT
+
+#include <stddef.h>
+
+typedef struct t_context t_context;
+
+/* Register one variable as per-instance state (used by *_context_regions functions) */
+#define CONTEXT_REGION(var) context_region(&(var), sizeof(var))
+
+/* Register pointers that may point into per-instance state, spaced by stride bytes */
+#define CONTEXT_POINTERS(first, count, stride) context_pointers((void *)&(first), count, stride)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Create a context holding power-on state (first call must happen before any ROM is loaded) */
+/* Contexts must be created and destroyed from a single thread */
+extern t_context *context_create(void);
+
+/* Save the calling thread's context and switch its globals to the given one (NULL releases it) */
+extern void context_select(t_context *ctx);
+
+/* Release a context and everything allocated by the instance it holds */
+extern void context_destroy(t_context *ctx);
+
+/* Context selected by the calling thread (NULL if none) */
+extern t_context *context_current(void);
+
+extern void context_region(void *base, size_t size);
+extern void context_pointers(void *first, int count, size_t stride);
+
+/* Per-module state registration */
+extern void areplay_context_regions(void);
+extern void eeprom_93c_context_regions(void);
+extern void eeprom_i2c_context_regions(void);
+extern void eeprom_spi_context_regions(void);
+extern void ggenie_context_regions(void);
+extern void sms_cart_context_regions(void);
+extern void sram_context_regions(void);
+extern void state_context_regions(void);
+extern void ssp16_context_regions(void);
+extern void svp_context_regions(void);
+extern void genesis_context_regions(void);
+extern void activator_context_regions(void);
+extern void gamepad_context_regions(void);
+extern void graphic_board_context_regions(void);
+extern void input_context_regions(void);
+extern void lightgun_context_regions(void);
+extern void mouse_context_regions(void);
+extern void paddle_context_regions(void);
+extern void sportspad_context_regions(void);
+extern void teamplayer_context_regions(void);
+extern void terebi_oekaki_context_regions(void);
+extern void xe_1ap_context_regions(void);
+extern void io_ctrl_context_regions(void);
+extern void loadrom_context_regions(void);
+extern void m68k_context_regions(void);
+extern void s68k_context_regions(void);
+extern void memz80_context_regions(void);
+extern void psg_context_regions(void);
+extern void sound_context_regions(void);
+extern void ym2413_context_regions(void);
+extern void ym2612_context_regions(void);
+extern void system_context_regions(void);
+extern void vdp_ctrl_context_regions(void);
+extern void vdp_render_context_regions(void);
+extern void z80_context_regions(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USE_CORE_CONTEXT */
+
+#endif /* _CONTEXT_H_ */
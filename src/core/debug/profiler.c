@@ -0,0 +1,124 @@
+/***************************************************************************************
+ *  Genesis Plus GX
+ *  Per-subsystem frame time profiler
+ *
+ *  ENABLE_PROFILER should be defined in a makefile to enable this functionality
+ *
+ ****************************************************************************************/
+
+#ifdef ENABLE_PROFILER
+
+#include <time.h>
+#include <string.h>
+#include "profiler.h"
+
+t_profiler profiler;
+
+static const char *const profiler_names[PROFILER_SECTIONS] =
+{
+  "other", "m68k", "s68k", "z80", "render", "dma", "sound", "blip", "video_backend", "sound_backend", "rewind", "idle"
+};
+
+/* Ring buffer of completed frames */
+static uint64_t profiler_ring[PROFILER_FRAMES][PROFILER_SECTIONS];
+static unsigned int profiler_count;
+
+/* Tick counter calibration against the monotonic clock */
+static uint64_t profiler_start_ticks;
+static uint64_t profiler_start_ns;
+
+uint64_t profiler_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/* Microseconds per tick, measured since last reset */
+static double profiler_us_per_tick(void)
+{
+  uint64_t ticks = profiler_ticks() - profiler_start_ticks;
+  uint64_t ns = profiler_ns() - profiler_start_ns;
+  return ticks ? (ns / 1000.0) / ticks : 0.0;
+}
+
+void profiler_reset(void)
+{
+  memset(&profiler, 0, sizeof(profiler));
+  memset(profiler_ring, 0, sizeof(profiler_ring));
+  profiler_count = 0;
+
+  profiler_start_ns = profiler_ns();
+  profiler_start_ticks = profiler_ticks();
+  profiler.last = profiler_start_ticks;
+}
+
+void profiler_frame(void)
+{
+  /* Close the time spent so far in the current section */
+  uint64_t now = profiler_ticks();
+  profiler.ticks[profiler.stack[profiler.depth]] += now - profiler.last;
+  profiler.last = now;
+
+  memcpy(profiler_ring[profiler_count & (PROFILER_FRAMES - 1)], profiler.ticks, sizeof(profiler.ticks));
+  memset(profiler.ticks, 0, sizeof(profiler.ticks));
+  profiler_count++;
+}
+
+int profiler_frames(void)
+{
+  return (profiler_count < PROFILER_FRAMES) ? profiler_count : PROFILER_FRAMES;
+}
+
+const char *profiler_section_name(int section)
+{
+  return profiler_names[section];
+}
+
+double profiler_average_us(int section)
+{
+  int frames = profiler_frames();
+  uint64_t total = 0;
+
+  if (!frames) return 0.0;
+
+  for (int i = 0; i < frames; i++)
+    total += profiler_ring[i][section];
+
+  return (total * profiler_us_per_tick()) / frames;
+}
+
+int profiler_dump_csv(const char *path)
+{
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) return 0;
+
+  double us_per_tick = profiler_us_per_tick();
+  int frames = profiler_frames();
+
+  fprintf(fp, "frame");
+  for (int s = 0; s < PROFILER_SECTIONS; s++)
+    fprintf(fp, ",%s_us", profiler_names[s]);
+  fprintf(fp, ",total_us\n");
+
+  /* oldest frame first */
+  for (int i = 0; i < frames; i++)
+  {
+    unsigned int frame = profiler_count - frames + i;
+    uint64_t *ticks = profiler_ring[frame & (PROFILER_FRAMES - 1)];
+    uint64_t total = 0;
+
+    fprintf(fp, "%u", frame);
+    for (int s = 0; s < PROFILER_SECTIONS; s++)
+    {
+      fprintf(fp, ",%.1f", ticks[s] * us_per_tick);
+      total += ticks[s];
+    }
+    fprintf(fp, ",%.1f\n", total * us_per_tick);
+  }
+
+  fclose(fp);
+  return 1;
+}
+
+#endif /* ENABLE_PROFILER */
@@ -0,0 +1,104 @@
+/***************************************************************************************
+ *  Genesis Plus GX
+ *  Per-subsystem frame time profiler
+ *
+ *  ENABLE_PROFILER should be defined in a makefile to enable this functionality
+ *
+ *  Each instrumented section adds the time spent in it (minus nested sections) to
+ *  a per-frame counter, read with rdtsc on x86 and clock_gettime elsewhere. Frames
+ *  are kept in a ring buffer that can be dumped as CSV. Counters are not thread-safe:
+ *  sections must all be entered from the emulation thread.
+ *
+ ****************************************************************************************/
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef enum {
+  PROFILER_OTHER = 0,       /* anything outside the sections below */
+  PROFILER_M68K,            /* m68k_run */
+  PROFILER_S68K,            /* s68k_run */
+  PROFILER_Z80,             /* z80_run */
+  PROFILER_RENDER,          /* render_line */
+  PROFILER_DMA,             /* vdp_dma_update */
+  PROFILER_SOUND,           /* audio_update (sound chips, filters) */
+  PROFILER_BLIP,            /* blip_read_samples / blip_mix_samples */
+  PROFILER_VIDEO_BACKEND,   /* Backend_Video_* calls */
+  PROFILER_SOUND_BACKEND,   /* Backend_Sound_* calls */
+  PROFILER_REWIND,          /* rewind_push / rewind_pop */
+  PROFILER_IDLE,            /* frame pacing waits */
+  PROFILER_SECTIONS
+} profiler_section_t;
+
+/* Number of frames kept in the ring buffer (power of two) */
+#define PROFILER_FRAMES 1024
+
+/* Maximal nesting of sections */
+#define PROFILER_DEPTH  16
+
+#ifdef ENABLE_PROFILER
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define profiler_ticks() __rdtsc()
+#else
+#define profiler_ticks() profiler_ns()
+#endif
+
+typedef struct
+{
+  uint64_t last;                        /* tick count when the current section was (re)entered */
+  int depth;                            /* index of the current section in stack */
+  uint8_t stack[PROFILER_DEPTH];        /* entered sections, PROFILER_OTHER at the bottom */
+  uint64_t ticks[PROFILER_SECTIONS];    /* ticks spent in each section during current frame */
+} t_profiler;
+
+extern t_profiler profiler;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint64_t profiler_ns(void);
+extern void profiler_reset(void);
+extern void profiler_frame(void);
+extern int profiler_frames(void);
+extern const char *profiler_section_name(int section);
+extern double profiler_average_us(int section);
+extern int profiler_dump_csv(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline void profiler_enter(int section)
+{
+  uint64_t now = profiler_ticks();
+  profiler.ticks[profiler.stack[profiler.depth]] += now - profiler.last;
+  profiler.last = now;
+  if (profiler.depth < (PROFILER_DEPTH - 1)) profiler.depth++;
+  profiler.stack[profiler.depth] = section;
+}
+
+static inline void profiler_leave(void)
+{
+  uint64_t now = profiler_ticks();
+  profiler.ticks[profiler.stack[profiler.depth]] += now - profiler.last;
+  profiler.last = now;
+  if (profiler.depth > 0) profiler.depth--;
+}
+
+#define PROFILER_ENTER(section) profiler_enter(section)
+#define PROFILER_LEAVE()        profiler_leave()
+
+#else
+
+#define PROFILER_ENTER(section)
+#define PROFILER_LEAVE()
+
+#endif /* ENABLE_PROFILER */
+
+#endif /* _PROFILER_H_ */
@@ -42,18 +42,18 @@
 #include "shared.h"
 
 #ifdef USE_DYNAMIC_ALLOC
-external_t *ext;
+CONTEXT_LOCAL external_t *ext;
 #else                     /* External Hardware (Cartridge, CD unit, ...) */
 external_t ext;
 #endif
-uint8 boot_rom[0x800];    /* Genesis BOOT ROM   */
-uint8 work_ram[0x10000];  /* 68K RAM  */
-uint8 zram[0x2000];       /* Z80 RAM  */
-uint32 zbank;             /* Z80 bank window address */
-uint8 zstate;             /* Z80 bus state (d0 = BUSACK, d1 = /RESET) */
-uint8 pico_current;       /* PICO current page */
+CONTEXT_LOCAL uint8 boot_rom[0x800];    /* Genesis BOOT ROM   */
+CONTEXT_LOCAL uint8 work_ram[0x10000];  /* 68K RAM  */
+CONTEXT_LOCAL uint8 zram[0x2000];       /* Z80 RAM  */
+CONTEXT_LOCAL uint32 zbank;             /* Z80 bank window address */
+CONTEXT_LOCAL uint8 zstate;             /* Z80 bus state (d0 = BUSACK, d1 = /RESET) */
+CONTEXT_LOCAL uint8 pico_current;       /* PICO current page */
 
-static uint8 tmss[4];     /* TMSS security register */
+static CONTEXT_LOCAL uint8 tmss[4];     /* TMSS security register */
 
 /*--------------------------------------------------------------------------*/
 /* Init, reset, shutdown functions                                          */
@@ -430,6 +430,8 @@ void gen_bankswitch_w(unsigned int data)
       /* enable internal BOOT ROM */
       m68k.memory_map[0].base = boot_rom;
     }
+
+    m68k_memory_map_update();
   }
 }
 
@@ -562,3 +564,17 @@ int z80_irq_callback (int param)
 {
   return -1;
 }
+
+#ifdef USE_CORE_CONTEXT
+void genesis_context_regions(void)
+{
+  CONTEXT_REGION(ext);
+  CONTEXT_REGION(boot_rom);
+  CONTEXT_REGION(work_ram);
+  CONTEXT_REGION(zram);
+  CONTEXT_REGION(zbank);
+  CONTEXT_REGION(zstate);
+  CONTEXT_REGION(pico_current);
+  CONTEXT_REGION(tmss);
+}
+#endif
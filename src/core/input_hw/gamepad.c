@@ -40,7 +40,7 @@
 #include "shared.h"
 #include "gamepad.h"
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 State;
   uint8 Counter;
@@ -48,13 +48,13 @@ static struct
   uint32 Latency;
 } gamepad[MAX_DEVICES];
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 Latch;
   uint8 Counter;
 } flipflop[2];
 
-static uint8 latch;
+static CONTEXT_LOCAL uint8 latch;
 
 
 void gamepad_reset(int port)
@@ -362,3 +362,12 @@ void mastertap_2_write(unsigned char data, unsigned char mask)
   /* update internal state */
   flipflop[1].Latch = data;
 }
+
+#ifdef USE_CORE_CONTEXT
+void gamepad_context_regions(void)
+{
+  CONTEXT_REGION(gamepad);
+  CONTEXT_REGION(flipflop);
+  CONTEXT_REGION(latch);
+}
+#endif
@@ -38,7 +38,7 @@
 
 #include "shared.h"
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 State;
   uint8 Counter;
@@ -109,3 +109,10 @@ void graphic_board_write(unsigned char data, unsigned char mask)
 
   board.State = data;
 }
+
+#ifdef USE_CORE_CONTEXT
+void graphic_board_context_regions(void)
+{
+  CONTEXT_REGION(board);
+}
+#endif
@@ -49,8 +49,8 @@
 #include "terebi_oekaki.h"
 #include "graphic_board.h"
 
-t_input input;
-int old_system[2] = {-1,-1};
+CONTEXT_LOCAL t_input input;
+CONTEXT_LOCAL int old_system[2] = {-1,-1};
 
 
 void input_init(void)
@@ -480,4 +480,12 @@ void input_end_frame(unsigned int cycles)
       }
     }
   }
-}
\ No newline at end of file
+}
+
+#ifdef USE_CORE_CONTEXT
+void input_context_regions(void)
+{
+  CONTEXT_REGION(input);
+  CONTEXT_REGION(old_system);
+}
+#endif
@@ -83,7 +83,7 @@ static const uint8 hc_320[210] =
   0xFE, 0xFF
 };
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 State;
   uint8 Port;
@@ -263,3 +263,10 @@ void justifier_write(unsigned char data, unsigned char mask)
   /* update internal state */
   lightgun.State = data;
 }
+
+#ifdef USE_CORE_CONTEXT
+void lightgun_context_regions(void)
+{
+  CONTEXT_REGION(lightgun);
+}
+#endif
@@ -38,7 +38,7 @@
 
 #include "shared.h"
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 State;
   uint8 Counter;
@@ -157,3 +157,10 @@ void mouse_write(unsigned char data, unsigned char mask)
   /* update internal state */
   mouse.State = data;
 }
+
+#ifdef USE_CORE_CONTEXT
+void mouse_context_regions(void)
+{
+  CONTEXT_REGION(mouse);
+}
+#endif
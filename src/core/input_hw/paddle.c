@@ -38,7 +38,7 @@
 
 #include "shared.h"
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 State;
 } paddle[2];
@@ -109,3 +109,10 @@ void paddle_2_write(unsigned char data, unsigned char mask)
 {
   paddle_write(1, data, mask);
 }
+
+#ifdef USE_CORE_CONTEXT
+void paddle_context_regions(void)
+{
+  CONTEXT_REGION(paddle);
+}
+#endif
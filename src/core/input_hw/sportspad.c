@@ -38,7 +38,7 @@
 
 #include "shared.h"
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 State;
   uint8 Counter;
@@ -132,3 +132,10 @@ void sportspad_2_write(unsigned char data, unsigned char mask)
 {
   sportspad_write(1, data, mask);
 }
+
+#ifdef USE_CORE_CONTEXT
+void sportspad_context_regions(void)
+{
+  CONTEXT_REGION(sportspad);
+}
+#endif
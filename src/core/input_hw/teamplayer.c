@@ -38,7 +38,7 @@
 
 #include "shared.h"
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 State;
   uint8 Counter;
@@ -175,3 +175,10 @@ void teamplayer_2_write(unsigned char data, unsigned char mask)
 {
   teamplayer_write(1, data, mask);
 }
+
+#ifdef USE_CORE_CONTEXT
+void teamplayer_context_regions(void)
+{
+  CONTEXT_REGION(teamplayer);
+}
+#endif
@@ -38,7 +38,7 @@
 
 #include "shared.h"
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 axis;
   uint8 busy;
@@ -75,3 +75,10 @@ void terebi_oekaki_write(unsigned char data)
   /* set BUSY flag */
   tablet.busy = 1;
 }
+
+#ifdef USE_CORE_CONTEXT
+void terebi_oekaki_context_regions(void)
+{
+  CONTEXT_REGION(tablet);
+}
+#endif
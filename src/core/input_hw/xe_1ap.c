@@ -40,7 +40,7 @@
 
 #define XE_1AP_LATENCY 3
 
-static struct
+static CONTEXT_LOCAL struct
 {
   uint8 State;
   uint8 Counter;
@@ -172,3 +172,10 @@ void xe_1ap_2_write(unsigned char data, unsigned char mask)
 {
   xe_1ap_write(1, data, mask);
 }
+
+#ifdef USE_CORE_CONTEXT
+void xe_1ap_context_regions(void)
+{
+  CONTEXT_REGION(xe_1ap);
+}
+#endif
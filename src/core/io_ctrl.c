@@ -50,11 +50,11 @@
 #include "sportspad.h"
 #include "graphic_board.h"
 
-uint8 io_reg[0x10];
+CONTEXT_LOCAL uint8 io_reg[0x10];
 
-uint8 region_code = REGION_USA;
+CONTEXT_LOCAL uint8 region_code = REGION_USA;
 
-static struct port_t
+static CONTEXT_LOCAL struct port_t
 {
   void (*data_w)(unsigned char data, unsigned char mask);
   unsigned char (*data_r)(void);
@@ -658,3 +658,11 @@ unsigned int io_gg_read(unsigned int offset)
   }
 }
 
+#ifdef USE_CORE_CONTEXT
+void io_ctrl_context_regions(void)
+{
+  CONTEXT_REGION(io_reg);
+  CONTEXT_REGION(region_code);
+  CONTEXT_REGION(port);
+}
+#endif
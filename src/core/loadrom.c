@@ -91,10 +91,10 @@ typedef struct
 } PERIPHERALINFO;
 
 
-ROMINFO rominfo;
-uint8 romtype;
+CONTEXT_LOCAL ROMINFO rominfo;
+CONTEXT_LOCAL uint8 romtype;
 
-static uint8 rom_region;
+static CONTEXT_LOCAL uint8 rom_region;
 
 /***************************************************************************
  * Genesis ROM Manufacturers
@@ -1200,3 +1200,11 @@ char *get_peripheral(int index)
   return (char *)companyinfo[MAXCOMPANY - 1].company;
 }
 
+#ifdef USE_CORE_CONTEXT
+void loadrom_context_regions(void)
+{
+  CONTEXT_REGION(rominfo);
+  CONTEXT_REGION(romtype);
+  CONTEXT_REGION(rom_region);
+}
+#endif
@@ -66,8 +66,8 @@ typedef struct
 
 
 /* Global variables */
-extern ROMINFO rominfo;
-extern uint8 romtype;
+extern CONTEXT_LOCAL ROMINFO rominfo;
+extern CONTEXT_LOCAL uint8 romtype;
 
 /* Function prototypes */
 extern int load_bios(int system);
@@ -50,6 +50,8 @@
 #ifdef HOOK_CPU
 #include "cpuhook.h"
 #endif
+#include "profiler.h"
+#include "context.h"
 
 /* ======================================================================== */
 /* ==================== ARCHITECTURE-DEPENDANT DEFINES ==================== */
@@ -241,6 +243,8 @@ typedef struct
 typedef struct
 {
   cpu_memory_map memory_map[256]; /* memory mapping */
+  unsigned char *direct_read[256];  /* memory_map base of pages without read handlers, NULL otherwise */
+  unsigned char *direct_write[256]; /* memory_map base of pages without write handlers, NULL otherwise */
 
   cpu_idle_t poll;      /* polling detection */
 
@@ -289,8 +293,8 @@ typedef struct
 } m68ki_cpu_core;
 
 /* CPU cores */
-extern m68ki_cpu_core m68k;
-extern m68ki_cpu_core s68k;
+extern CONTEXT_LOCAL m68ki_cpu_core m68k;
+extern CONTEXT_LOCAL m68ki_cpu_core s68k;
 
 
 /* ======================================================================== */
@@ -388,6 +392,15 @@ extern void m68k_clear_halt(void);
 extern void s68k_pulse_halt(void);
 extern void s68k_clear_halt(void);
 
+/* Drop pre-decoded instructions (M68K_PREDECODE=1), to be called whenever */
+/* cartridge ROM contents are modified outside of CPU writes               */
+extern void m68k_predecode_flush(void);
+
+/* Rebuild the direct access tables from memory_map, to be called whenever */
+/* a page base or handler is modified (mappers, TMSS, Word-RAM switching)  */
+extern void m68k_memory_map_update(void);
+extern void s68k_memory_map_update(void);
+
 
 /* Peek at the internals of a CPU context.  This can either be a context
  * retrieved using m68k_get_context() or the currently running context.
@@ -15,6 +15,19 @@ extern int vdp_68k_irq_ack(int int_level);
 #include "m68ki_cycles.h"
 #endif
 
+#ifdef USE_M68K_PREDECODE
+#include "shared.h"
+#endif
+
+#ifdef USE_M68K_JIT
+#include <stddef.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
 #include "m68kconf.h"
 #include "m68kcpu.h"
 #include "m68kops.h"
@@ -27,9 +40,79 @@ extern int vdp_68k_irq_ack(int int_level);
 static unsigned char m68ki_cycles[0x10000];
 #endif
 
-static int irq_latency;
+static CONTEXT_LOCAL int irq_latency;
+
+CONTEXT_LOCAL m68ki_cpu_core m68k;
+
+#ifdef USE_M68K_PREDECODE
+/* Pre-decoded blocks of code running from cartridge ROM: straight-line runs */
+/* of instructions, looked up by the location of their first instruction in */
+/* cart.rom (so bank switching needs no invalidation)                       */
+#define M68K_BLOCKS      0x200
+#ifdef USE_M68K_JIT
+#define M68K_BLOCK_INSNS 32
+#else
+#define M68K_BLOCK_INSNS 16
+#endif
+
+typedef struct
+{
+  void (*handler)(void);    /* m68ki_instruction_jump_table[ir] */
+  uint16 ir;                /* opcode */
+  uint16 cycles;            /* CYC_INSTRUCTION[ir] */
+  uint length;              /* offset of the next instruction (0 = end of block) */
+} m68ki_decoded_t;
+
+typedef struct
+{
+  const uint8 *start;       /* first instruction in cart.rom (NULL = unused) */
+  uint count;               /* instructions decoded so far */
+#ifdef USE_M68K_JIT
+  uint runs;                /* times the block was entered */
+  void (*code)(uint cycles, uint8 *const *base); /* translated block (NULL = none yet) */
+  uint8 *top;               /* translated instructions, jumped to by linked blocks */
+#endif
+  m68ki_decoded_t insn[M68K_BLOCK_INSNS];
+} m68ki_block_t;
+
+static CONTEXT_LOCAL m68ki_block_t m68ki_blocks[M68K_BLOCKS];
+#endif
+
+#ifdef USE_M68K_JIT
+#ifndef USE_M68K_PREDECODE
+#error "USE_M68K_JIT requires USE_M68K_PREDECODE"
+#endif
+#if !defined(__x86_64__) && !defined(_M_X64)
+#error "USE_M68K_JIT requires an x86-64 host"
+#endif
+#ifdef USE_CORE_CONTEXT
+#error "USE_M68K_JIT can't be used with USE_CORE_CONTEXT"
+#endif
+#if M68K_EMULATE_TRACE || M68K_EMULATE_FC
+#error "USE_M68K_JIT can't be used with M68K_EMULATE_TRACE or M68K_EMULATE_FC"
+#endif
 
-m68ki_cpu_core m68k;
+/* Blocks entered this many times are translated to x86-64 code */
+#define M68K_JIT_THRESHOLD 8
+#define M68K_JIT_SIZE      0x400000
+
+static uint8 *m68ki_jit_buffer;   /* executable memory (NULL = not allocated yet) */
+static uint m68ki_jit_used;
+static int m68ki_jit_failed;      /* executable memory could not be allocated */
+static uint m68ki_jit_epoch;      /* bumped when blocks are flushed */
+#ifdef M68K_OVERCLOCK_SHIFT
+static int m68ki_jit_ratio;       /* cycle ratio translated code counts with */
+#endif
+
+/* How translated code was left: at the end of a block (site = its chaining */
+/* site, NULL otherwise), with r15 = base and r13d = pc                    */
+static struct
+{
+  uint8 *site;
+  const uint8 *base;
+  uint pc;
+} m68ki_jit_exit;
+#endif
 
 
 /* ======================================================================== */
@@ -190,7 +273,7 @@ void m68k_set_fc_callback(void  (*callback)(unsigned int new_fc))
 
 #ifdef LOGVDP
 extern void error(char *format, ...);
-extern uint16 v_counter;
+extern CONTEXT_LOCAL uint16 v_counter;
 #endif
 
 /* ASG: rewrote so that the int_level is a mask of the IPL0/IPL1/IPL2 bits */
@@ -253,6 +336,688 @@ void m68k_set_irq_delay(unsigned int int_level)
   m68ki_check_interrupts(); /* Level triggered (IRQ) */
 }
 
+#ifdef USE_M68K_JIT
+/* x86-64 emitter: p is the output pointer */
+#define JIT_OP(s)   (memcpy(p, s, sizeof(s) - 1), p += sizeof(s) - 1)
+#define JIT_U32(v)  (*(uint32 *)p = (uint32)(v), p += 4)
+#define JIT_U64(v)  (*(uint64_t *)p = (uint64_t)(uintptr_t)(v), p += 8)
+#define JIT_JCC(cc, target) (JIT_OP("\x0f"), *p++ = 0x80 | (cc), JIT_U32((target) - (p + 4)))
+#define JIT_DISP(f) JIT_U32(offsetof(m68ki_cpu_core, f))
+
+#define JIT_JE  0x4
+#define JIT_JNE 0x5
+#define JIT_JAE 0x3
+
+/* Chaining site of a block: cmp eax, delta / jne / add r13d, eax / mov rcx, target */
+#define JIT_LINK_DELTA  1
+#define JIT_LINK_TARGET 16
+
+/* x86-64 registers used by translated instructions (caller-saved) */
+#define JIT_EAX 0
+#define JIT_ECX 1
+#define JIT_EDX 2
+#define JIT_R8D 8
+#define JIT_R9D 9
+#define JIT_R10D 10
+
+#define JIT_MOV 0x89
+#define JIT_ADD 0x01
+#define JIT_OR  0x09
+#define JIT_AND 0x21
+#define JIT_SUB 0x29
+#define JIT_XOR 0x31
+
+#define JIT_DAR(n)  (offsetof(m68ki_cpu_core, dar) + ((n) << 2))
+#define JIT_FLAG(f) offsetof(m68ki_cpu_core, f)
+
+static uint8 *m68ki_jit_rex(uint8 *p, int reg, int rm)
+{
+  if ((reg | rm) & 8) *p++ = 0x40 | ((reg >> 3) << 2) | (rm >> 3);
+  return p;
+}
+
+/* op dst, src (32-bit registers) */
+static uint8 *m68ki_jit_rr(uint8 *p, uint op, int dst, int src)
+{
+  p = m68ki_jit_rex(p, src, dst);
+  *p++ = op;
+  *p++ = 0xc0 | ((src & 7) << 3) | (dst & 7);
+  return p;
+}
+
+/* op dst(, imm): group 1 (0x81) with 32-bit, shifts (0xc1) with 8-bit immediate, */
+/* group 3 (0xf7) without                                                          */
+static uint8 *m68ki_jit_ri(uint8 *p, uint op, uint ext, int dst, uint imm)
+{
+  p = m68ki_jit_rex(p, 0, dst);
+  *p++ = op;
+  *p++ = 0xc0 | (ext << 3) | (dst & 7);
+  if (op == 0x81) JIT_U32(imm);
+  else if (op == 0xc1) *p++ = imm;
+  return p;
+}
+
+/* mov reg, [rbx + disp] */
+static uint8 *m68ki_jit_load(uint8 *p, int reg, uint disp)
+{
+  p = m68ki_jit_rex(p, reg, 0);
+  *p++ = 0x8b;
+  *p++ = 0x83 | ((reg & 7) << 3);
+  JIT_U32(disp);
+  return p;
+}
+
+/* mov [rbx + disp], reg (8, 16 or 32 bits) */
+static uint8 *m68ki_jit_store(uint8 *p, int reg, uint disp, int size)
+{
+  if (size == 16) *p++ = 0x66;
+  p = m68ki_jit_rex(p, reg, 0);
+  *p++ = (size == 8) ? 0x88 : 0x89;
+  *p++ = 0x83 | ((reg & 7) << 3);
+  JIT_U32(disp);
+  return p;
+}
+
+/* mov dword [rbx + disp], imm */
+static uint8 *m68ki_jit_store_imm(uint8 *p, uint disp, uint imm)
+{
+  JIT_OP("\xc7\x83"); JIT_U32(disp); JIT_U32(imm);
+  return p;
+}
+
+/* reg = data or address register n, masked to size */
+static uint8 *m68ki_jit_operand(uint8 *p, int reg, uint n, int size)
+{
+  p = m68ki_jit_load(p, reg, JIT_DAR(n));
+  if (size < 32) p = m68ki_jit_ri(p, 0x81, 4, reg, (1 << size) - 1);
+  return p;
+}
+
+/* FLAG_N and FLAG_Z from the (masked) result in eax, FLAG_V and FLAG_C cleared */
+static uint8 *m68ki_jit_logic_flags(uint8 *p, int size)
+{
+  p = m68ki_jit_store(p, JIT_EAX, JIT_FLAG(not_z_flag), 32);
+  p = m68ki_jit_rr(p, JIT_MOV, JIT_ECX, JIT_EAX);
+  if (size > 8) p = m68ki_jit_ri(p, 0xc1, 5, JIT_ECX, size - 8);
+  p = m68ki_jit_store(p, JIT_ECX, JIT_FLAG(n_flag), 32);
+  p = m68ki_jit_store_imm(p, JIT_FLAG(v_flag), VFLAG_CLEAR);
+  p = m68ki_jit_store_imm(p, JIT_FLAG(c_flag), CFLAG_CLEAR);
+  return p;
+}
+
+/* eax = edx + ecx or edx - ecx (dst, src masked to size) with the flags set */
+/* the way ADD/SUB/CMP handlers do (X too, unless cmp); eax is then masked   */
+static uint8 *m68ki_jit_arith(uint8 *p, int size, int sub, int cmp)
+{
+  p = m68ki_jit_rr(p, JIT_MOV, JIT_EAX, JIT_EDX);
+  p = m68ki_jit_rr(p, sub ? JIT_SUB : JIT_ADD, JIT_EAX, JIT_ECX);
+
+  /* NFLAG, CFLAG_8/16 */
+  p = m68ki_jit_rr(p, JIT_MOV, JIT_R8D, JIT_EAX);
+  if (size > 8) p = m68ki_jit_ri(p, 0xc1, 5, JIT_R8D, size - 8);
+  p = m68ki_jit_store(p, JIT_R8D, JIT_FLAG(n_flag), 32);
+
+  if (size == 32)
+  {
+    /* CFLAG_ADD_32: ((S & D) | (~R & (S | D))) >> 23 */
+    /* CFLAG_SUB_32: ((S & R) | (~D & (S | R))) >> 23 */
+    p = m68ki_jit_rr(p, JIT_MOV, JIT_R8D, JIT_ECX);
+    p = m68ki_jit_rr(p, JIT_AND, JIT_R8D, sub ? JIT_EAX : JIT_EDX);
+    p = m68ki_jit_rr(p, JIT_MOV, JIT_R9D, JIT_ECX);
+    p = m68ki_jit_rr(p, JIT_OR, JIT_R9D, sub ? JIT_EAX : JIT_EDX);
+    p = m68ki_jit_rr(p, JIT_MOV, JIT_R10D, sub ? JIT_EDX : JIT_EAX);
+    p = m68ki_jit_ri(p, 0xf7, 2, JIT_R10D, 0);      /* not r10d */
+    p = m68ki_jit_rr(p, JIT_AND, JIT_R10D, JIT_R9D);
+    p = m68ki_jit_rr(p, JIT_OR, JIT_R8D, JIT_R10D);
+    p = m68ki_jit_ri(p, 0xc1, 5, JIT_R8D, 23);
+  }
+  p = m68ki_jit_store(p, JIT_R8D, JIT_FLAG(c_flag), 32);
+  if (!cmp) p = m68ki_jit_store(p, JIT_R8D, JIT_FLAG(x_flag), 32);
+
+  /* VFLAG_ADD: ((S ^ R) & (D ^ R)), VFLAG_SUB: ((S ^ D) & (R ^ D)) */
+  p = m68ki_jit_rr(p, JIT_MOV, JIT_R8D, JIT_ECX);
+  p = m68ki_jit_rr(p, JIT_XOR, JIT_R8D, sub ? JIT_EDX : JIT_EAX);
+  p = m68ki_jit_rr(p, JIT_MOV, JIT_R9D, sub ? JIT_EAX : JIT_EDX);
+  p = m68ki_jit_rr(p, JIT_XOR, JIT_R9D, sub ? JIT_EDX : JIT_EAX);
+  p = m68ki_jit_rr(p, JIT_AND, JIT_R8D, JIT_R9D);
+  if (size > 8) p = m68ki_jit_ri(p, 0xc1, 5, JIT_R8D, size - 8);
+  p = m68ki_jit_store(p, JIT_R8D, JIT_FLAG(v_flag), 32);
+
+  /* ZFLAG */
+  if (size < 32) p = m68ki_jit_ri(p, 0x81, 4, JIT_EAX, (1 << size) - 1);
+  p = m68ki_jit_store(p, JIT_EAX, JIT_FLAG(not_z_flag), 32);
+  return p;
+}
+
+/* Translate instructions only working on registers (and immediate data) to */
+/* native code, as their handlers would run. Returns NULL if not supported.  */
+/* ext = extension words, pc = offset of the instruction in the block.      */
+static uint8 *m68ki_jit_native(uint8 *p, uint ir, const uint8 *ext, uint length, uint pc)
+{
+  uint x = (ir >> 9) & 7;
+  uint y = ir & 7;
+  uint mode = (ir >> 3) & 7;
+  uint ss = (ir >> 6) & 3;
+  int size = 8 << ss;
+  uint imm = (length >= 4) ? *(uint16 *)ext : 0;
+  uint imm_length = (ss == 2) ? 6 : 4;
+
+  if ((ss == 2) && (length >= 6)) imm = (imm << 16) | *(uint16 *)(ext + 2);
+  else if (ss == 0) imm &= 0xff;
+
+  switch (ir >> 12)
+  {
+    case 0x0:
+    {
+      /* ORI, ANDI, SUBI, ADDI, EORI, CMPI #imm, Dy (bits 3-5 of logical */
+      /* ops give their group 1 extension)                              */
+      static const uint8 ops[8] = {JIT_OR, JIT_AND, JIT_SUB, JIT_ADD, 0, JIT_XOR, JIT_SUB, 0};
+
+      if ((ir & 0x100) || mode || (ss == 3) || !ops[x] || (length != imm_length)) return NULL;
+
+      if ((x == 2) || (x == 3) || (x == 6))
+      {
+        *p++ = 0xb9; JIT_U32(imm);    /* mov ecx, imm */
+        p = m68ki_jit_operand(p, JIT_EDX, y, size);
+        p = m68ki_jit_arith(p, size, x != 3, x == 6);
+        if (x != 6) p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(y), size);
+        return p;
+      }
+
+      p = m68ki_jit_load(p, JIT_EAX, JIT_DAR(y));
+      p = m68ki_jit_ri(p, 0x81, (ops[x] >> 3) & 7, JIT_EAX, imm);
+      p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(y), size);
+      if (size < 32) p = m68ki_jit_ri(p, 0x81, 4, JIT_EAX, (1 << size) - 1);
+      return m68ki_jit_logic_flags(p, size);
+    }
+
+    case 0x1: case 0x2: case 0x3:
+    {
+      /* MOVE Dy/Ay/#imm, Dx and MOVEA Dy/Ay, Ax */
+      uint dst_mode = (ir >> 6) & 7;
+      size = (ir & 0x1000) ? ((ir & 0x2000) ? 16 : 8) : 32;
+
+      if (mode == 7)
+      {
+        if ((y != 4) || dst_mode || (length != ((size == 32) ? 6 : 4))) return NULL;
+        imm = *(uint16 *)ext;
+        if (size == 32) imm = (imm << 16) | *(uint16 *)(ext + 2);
+        else if (size == 8) imm &= 0xff;
+        *p++ = 0xb8; JIT_U32(imm);    /* mov eax, imm */
+      }
+      else
+      {
+        if ((mode > 1) || (dst_mode > 1) || ((size == 8) && (mode || dst_mode)) || (length != 2)) return NULL;
+        p = m68ki_jit_operand(p, JIT_EAX, (mode << 3) | y, size);
+      }
+
+      if (dst_mode)
+      {
+        if (size == 16) JIT_OP("\x0f\xbf\xc0"); /* movsx eax, ax */
+        return m68ki_jit_store(p, JIT_EAX, JIT_DAR(8 + x), 32);
+      }
+
+      p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(x), size);
+      return m68ki_jit_logic_flags(p, size);
+    }
+
+    case 0x4:
+      if (length == 2)
+      {
+        if (((ir & 0xff00) == 0x4a00) && (ss != 3) && !mode)
+        {
+          /* TST Dy */
+          p = m68ki_jit_operand(p, JIT_EAX, y, size);
+          return m68ki_jit_logic_flags(p, size);
+        }
+
+        if (((ir & 0xff00) == 0x4200) && (ss != 3) && !mode)
+        {
+          /* CLR Dy */
+          JIT_OP("\x31\xc0");     /* xor eax, eax */
+          p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(y), size);
+          return m68ki_jit_logic_flags(p, size);
+        }
+
+        if ((ir & 0xfff8) == 0x4840)
+        {
+          /* SWAP Dy */
+          p = m68ki_jit_load(p, JIT_EAX, JIT_DAR(y));
+          p = m68ki_jit_ri(p, 0xc1, 0, JIT_EAX, 16);
+          p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(y), 32);
+          return m68ki_jit_logic_flags(p, 32);
+        }
+
+        if ((ir & 0xfff8) == 0x48c0)
+        {
+          /* EXT.L Dy */
+          p = m68ki_jit_load(p, JIT_EAX, JIT_DAR(y));
+          JIT_OP("\x0f\xbf\xc0"); /* movsx eax, ax */
+          p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(y), 32);
+          return m68ki_jit_logic_flags(p, 32);
+        }
+
+        if ((ir & 0xfff8) == 0x4880)
+        {
+          /* EXT.W Dy: FLAG_N comes from the whole register */
+          p = m68ki_jit_load(p, JIT_EAX, JIT_DAR(y));
+          JIT_OP("\x0f\xbe\xc8"); /* movsx ecx, al */
+          p = m68ki_jit_store(p, JIT_ECX, JIT_DAR(y), 16);
+          p = m68ki_jit_load(p, JIT_EAX, JIT_DAR(y));
+          p = m68ki_jit_rr(p, JIT_MOV, JIT_ECX, JIT_EAX);
+          p = m68ki_jit_ri(p, 0xc1, 5, JIT_ECX, 8);
+          p = m68ki_jit_store(p, JIT_ECX, JIT_FLAG(n_flag), 32);
+          p = m68ki_jit_ri(p, 0x81, 4, JIT_EAX, 0xffff);
+          p = m68ki_jit_store(p, JIT_EAX, JIT_FLAG(not_z_flag), 32);
+          p = m68ki_jit_store_imm(p, JIT_FLAG(v_flag), VFLAG_CLEAR);
+          return m68ki_jit_store_imm(p, JIT_FLAG(c_flag), CFLAG_CLEAR);
+        }
+      }
+
+      if ((ir & 0xf1c0) == 0x41c0)
+      {
+        /* LEA (d16,Ay) / (xxx).W / (xxx).L / (d16,PC), Ax */
+        imm = (length >= 4) ? *(uint16 *)ext : 0;
+        if ((mode == 5) && (length == 4))
+        {
+          p = m68ki_jit_load(p, JIT_EAX, JIT_DAR(8 + y));
+          p = m68ki_jit_ri(p, 0x81, 0, JIT_EAX, (uint)(sint16)imm);
+        }
+        else if ((mode == 7) && (y == 0) && (length == 4))
+        {
+          *p++ = 0xb8; JIT_U32((uint)(sint16)imm);
+        }
+        else if ((mode == 7) && (y == 1) && (length == 6))
+        {
+          *p++ = 0xb8; JIT_U32((imm << 16) | *(uint16 *)(ext + 2));
+        }
+        else if ((mode == 7) && (y == 2) && (length == 4))
+        {
+          JIT_OP("\x41\x8d\x85"); JIT_U32(pc + 2 + (sint16)imm); /* lea eax, [r13 + disp] */
+        }
+        else return NULL;
+        return m68ki_jit_store(p, JIT_EAX, JIT_DAR(8 + x), 32);
+      }
+      return NULL;
+
+    case 0x5:
+    {
+      /* ADDQ/SUBQ #q, Dy/Ay */
+      uint q = ((x - 1) & 7) + 1;
+      int sub = (ir >> 8) & 1;
+
+      if ((ss == 3) || (mode > 1) || ((mode == 1) && !ss) || (length != 2)) return NULL;
+
+      if (mode)
+      {
+        p = m68ki_jit_load(p, JIT_EAX, JIT_DAR(8 + y));
+        p = m68ki_jit_ri(p, 0x81, sub ? 5 : 0, JIT_EAX, q);
+        return m68ki_jit_store(p, JIT_EAX, JIT_DAR(8 + y), 32);
+      }
+
+      *p++ = 0xb9; JIT_U32(q);      /* mov ecx, q */
+      p = m68ki_jit_operand(p, JIT_EDX, y, size);
+      p = m68ki_jit_arith(p, size, sub, 0);
+      return m68ki_jit_store(p, JIT_EAX, JIT_DAR(y), size);
+    }
+
+    case 0x7:
+      /* MOVEQ #imm, Dx */
+      if ((ir & 0x100) || (length != 2)) return NULL;
+      *p++ = 0xb8; JIT_U32((uint)(sint8)ir);
+      p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(x), 32);
+      return m68ki_jit_logic_flags(p, 32);
+
+    case 0x8: case 0xc:
+      /* OR/AND Dy, Dx */
+      if ((ir & 0x100) || (ss == 3) || mode || (length != 2)) return NULL;
+      p = m68ki_jit_load(p, JIT_EAX, JIT_DAR(x));
+      p = m68ki_jit_load(p, JIT_EDX, JIT_DAR(y));
+      p = m68ki_jit_rr(p, (ir & 0x4000) ? JIT_AND : JIT_OR, JIT_EAX, JIT_EDX);
+      p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(x), size);
+      if (size < 32) p = m68ki_jit_ri(p, 0x81, 4, JIT_EAX, (1 << size) - 1);
+      return m68ki_jit_logic_flags(p, size);
+
+    case 0xb:
+      if ((ir & 0x100) && (ss != 3))
+      {
+        /* EOR Dx, Dy */
+        if (mode || (length != 2)) return NULL;
+        p = m68ki_jit_load(p, JIT_EAX, JIT_DAR(y));
+        p = m68ki_jit_load(p, JIT_EDX, JIT_DAR(x));
+        p = m68ki_jit_rr(p, JIT_XOR, JIT_EAX, JIT_EDX);
+        p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(y), size);
+        if (size < 32) p = m68ki_jit_ri(p, 0x81, 4, JIT_EAX, (1 << size) - 1);
+        return m68ki_jit_logic_flags(p, size);
+      }
+      /* fall through */
+
+    case 0x9: case 0xd:
+      /* SUB/ADD/CMP Dy/Ay, Dx */
+      if ((ir & 0x100) || (ss == 3) || (mode > 1) || ((mode == 1) && !ss) || (length != 2)) return NULL;
+      p = m68ki_jit_operand(p, JIT_ECX, (mode << 3) | y, size);
+      p = m68ki_jit_operand(p, JIT_EDX, x, size);
+      p = m68ki_jit_arith(p, size, (ir >> 12) != 0xd, (ir >> 12) == 0xb);
+      if ((ir >> 12) != 0xb) p = m68ki_jit_store(p, JIT_EAX, JIT_DAR(x), size);
+      return p;
+  }
+
+  return NULL;
+}
+
+/* Translate a block to x86-64 code: register-only instructions are run   */
+/* natively (m68ki_jit_native), others by calling their handler, with the */
+/* interpreter's cycle counting and exit checks after each instruction:   */
+/* the code returns (to the interpreter) at the first instruction boundary */
+/* where the cycle count is reached, blocks are flushed or the page is    */
+/* remapped. Branches taken back to the start of the block loop in place, */
+/* others go on with the translated block they lead to once linked (see   */
+/* m68ki_jit_link) or return. The code is called as                       */
+/* code(cycles, &memory_map[page].base) and keeps rbx = &m68k,            */
+/* rbp = &m68ki_jit_epoch, r12d = cycles, r13d = PC of the block,         */
+/* r14 = &base and r15 = base.                                            */
+static void m68ki_jit_compile(m68ki_block_t *block)
+{
+  uint8 *p, *leave, *leave_end, *top;
+  uint8 *branches[M68K_BLOCK_INSNS];
+  uint i, offset = 0, count = 0;
+
+  if (!m68ki_jit_buffer)
+  {
+    if (m68ki_jit_failed) return;
+#ifdef _WIN32
+    m68ki_jit_buffer = VirtualAlloc(NULL, M68K_JIT_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+    m68ki_jit_buffer = mmap(NULL, M68K_JIT_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m68ki_jit_buffer == MAP_FAILED) m68ki_jit_buffer = NULL;
+#endif
+    if (!m68ki_jit_buffer)
+    {
+      m68ki_jit_failed = 1;
+      return;
+    }
+  }
+
+  /* Largest block: 192 bytes of prologue/epilogue and per instruction */
+  if ((m68ki_jit_used + ((block->count + 1) * 192)) > M68K_JIT_SIZE)
+  {
+    /* Start over (no translated code is running while blocks are compiled) */
+    m68k_predecode_flush();
+    return;
+  }
+
+  p = m68ki_jit_buffer + m68ki_jit_used;
+
+  /* Epilogues first, so that all exits are backward jumps */
+  leave_end = p;
+  JIT_OP("\x48\xb8"); JIT_U64(&m68ki_jit_exit);   /* mov rax, &m68ki_jit_exit */
+  JIT_OP("\x4c\x89\x78\x08");                     /* mov [rax + 8], r15 */
+  JIT_OP("\x44\x89\x68\x10");                     /* mov [rax + 16], r13d */
+  JIT_OP("\x48\xb9"); p += 8;                     /* mov rcx, chaining site (below) */
+  JIT_OP("\xeb\x0c");                             /* jmp store */
+  leave = p;
+  JIT_OP("\x48\xb8"); JIT_U64(&m68ki_jit_exit);   /* mov rax, &m68ki_jit_exit */
+  JIT_OP("\x31\xc9");                             /* xor ecx, ecx */
+  JIT_OP("\x48\x89\x08");                         /* store: mov [rax], rcx */
+#ifdef _WIN32
+  JIT_OP("\x48\x83\xc4\x28");                     /* add rsp, 40 */
+#else
+  JIT_OP("\x48\x83\xc4\x08");                     /* add rsp, 8 */
+#endif
+  JIT_OP("\x41\x5f\x41\x5e\x41\x5d\x41\x5c\x5d\x5b\xc3"); /* pop r15-r12, rbp, rbx; ret */
+
+  block->code = (void (*)(uint, uint8 *const *))p;
+  JIT_OP("\x53\x55\x41\x54\x41\x55\x41\x56\x41\x57"); /* push rbx, rbp, r12-r15 */
+#ifdef _WIN32
+  JIT_OP("\x48\x83\xec\x28");                     /* sub rsp, 40 (shadow space) */
+  JIT_OP("\x41\x89\xcc");                         /* mov r12d, ecx */
+  JIT_OP("\x49\x89\xd6");                         /* mov r14, rdx */
+#else
+  JIT_OP("\x48\x83\xec\x08");                     /* sub rsp, 8 */
+  JIT_OP("\x41\x89\xfc");                         /* mov r12d, edi */
+  JIT_OP("\x49\x89\xf6");                         /* mov r14, rsi */
+#endif
+  JIT_OP("\x48\xbb"); JIT_U64(&m68ki_cpu);        /* mov rbx, &m68k */
+  JIT_OP("\x48\xbd"); JIT_U64(&m68ki_jit_epoch);  /* mov rbp, &m68ki_jit_epoch */
+  JIT_OP("\x4d\x8b\x3e");                         /* mov r15, [r14] */
+  JIT_OP("\x44\x8b\xab"); JIT_DISP(pc);           /* mov r13d, [rbx + pc] */
+
+  top = block->top = p;
+  for (i = 0; i < block->count; i++)
+  {
+    m68ki_decoded_t *insn = &block->insn[i];
+    uint8 *native;
+
+    JIT_OP("\xc7\x83"); JIT_DISP(ir); JIT_U32(insn->ir); /* REG_IR = insn->ir */
+
+    native = insn->length ? m68ki_jit_native(p, insn->ir, block->start + offset + 2, insn->length, offset) : NULL;
+    if (native)
+    {
+      /* REG_PC = next instruction */
+      p = native;
+      offset += insn->length;
+      JIT_OP("\x41\x8d\x85"); JIT_U32(offset);    /* lea eax, [r13 + offset] */
+      JIT_OP("\x89\x83"); JIT_DISP(pc);           /* mov [rbx + pc], eax */
+    }
+    else
+    {
+      /* REG_PC += 2; insn->handler() */
+      JIT_OP("\x83\x83"); JIT_DISP(pc); JIT_OP("\x02");
+      JIT_OP("\x48\xb8"); JIT_U64(insn->handler); /* mov rax, handler */
+      JIT_OP("\xff\xd0");                         /* call rax */
+
+      /* USE_CYCLES(CYC_INSTRUCTION[REG_IR]): the handler may have run the */
+      /* next instruction itself (m68k_set_irq_delay)                      */
+      JIT_OP("\x8b\x83"); JIT_DISP(ir);           /* mov eax, [rbx + ir] */
+      JIT_OP("\x48\xb9"); JIT_U64(CYC_INSTRUCTION); /* mov rcx, CYC_INSTRUCTION */
+      JIT_OP("\x0f\xb6\x04\x01");                 /* movzx eax, byte [rcx + rax] */
+#ifdef M68K_OVERCLOCK_SHIFT
+      JIT_OP("\x69\xc0"); JIT_U32(m68ki_cpu.cycle_ratio); /* imul eax, eax, ratio */
+      JIT_OP("\xc1\xe8"); *p++ = M68K_OVERCLOCK_SHIFT;  /* shr eax, shift */
+#endif
+      JIT_OP("\x01\x83"); JIT_DISP(cycles);       /* add [rbx + cycles], eax */
+    }
+
+    if (native)
+    {
+      /* USE_CYCLES(insn->cycles) */
+#ifdef M68K_OVERCLOCK_SHIFT
+      JIT_OP("\x81\x83"); JIT_DISP(cycles); JIT_U32((insn->cycles * m68ki_cpu.cycle_ratio) >> M68K_OVERCLOCK_SHIFT);
+#else
+      JIT_OP("\x81\x83"); JIT_DISP(cycles); JIT_U32(insn->cycles);
+#endif
+    }
+
+    /* Leave once the block or page mapping is gone (handlers only), before */
+    /* leave_end can store a chaining site in a flushed buffer             */
+    if (!native)
+    {
+      JIT_OP("\x81\x7d\x00"); JIT_U32(m68ki_jit_epoch); /* cmp dword [rbp], epoch */
+      JIT_JCC(JIT_JNE, leave);
+      JIT_OP("\x4d\x39\x3e");                     /* cmp [r14], r15 */
+      JIT_JCC(JIT_JNE, leave);
+    }
+
+    /* ... when done */
+    JIT_OP("\x44\x39\xa3"); JIT_DISP(cycles);     /* cmp [rbx + cycles], r12d */
+    JIT_JCC(JIT_JAE, insn->length ? leave : leave_end);
+
+    if (native) continue;
+
+    /* ... or on branches (to the end of the block) */
+    if (insn->length)
+    {
+      offset += insn->length;
+      JIT_OP("\x41\x8d\x85"); JIT_U32(offset);    /* lea eax, [r13 + offset] */
+      JIT_OP("\x39\x83"); JIT_DISP(pc);           /* cmp [rbx + pc], eax */
+      JIT_OP("\x0f\x85"); branches[count++] = p; p += 4; /* jne end */
+    }
+  }
+
+  /* End of block (always a branch or an instruction not followed by the next) */
+  /* or branch taken in the block: loop in place or go on with the linked block */
+  for (i = 0; i < count; i++)
+  {
+    *(uint32 *)branches[i] = p - (branches[i] + 4);
+  }
+  JIT_OP("\x8b\x83"); JIT_DISP(pc);               /* mov eax, [rbx + pc] */
+  JIT_OP("\x44\x29\xe8");                         /* sub eax, r13d */
+  JIT_JCC(JIT_JE, top);
+  *(uint8 **)(leave_end + 20) = p;                /* chaining site for m68ki_jit_link */
+  JIT_OP("\x3d"); JIT_U32(0);                     /* cmp eax, delta (0 = not linked) */
+  JIT_JCC(JIT_JNE, leave_end);
+  JIT_OP("\x41\x01\xc5");                         /* add r13d, eax */
+  JIT_OP("\x48\xb9"); JIT_U64(0);                 /* mov rcx, target */
+  JIT_OP("\xff\xe1");                             /* jmp rcx */
+
+  m68ki_jit_used = (p - m68ki_jit_buffer + 15) & ~15;
+}
+
+/* Chain the block translated code left (at the end of the block) to the */
+/* translated block now starting at PC, if that is on the same page      */
+static void m68ki_jit_link(m68ki_block_t *block, const uint8 *base)
+{
+  uint8 *site = m68ki_jit_exit.site;
+  uint delta = REG_PC - m68ki_jit_exit.pc;
+
+  m68ki_jit_exit.site = NULL;
+
+  if (site && (m68ki_jit_exit.base == base) && !((REG_PC ^ m68ki_jit_exit.pc) & 0xff0000) &&
+      !*(uint32 *)(site + JIT_LINK_DELTA))
+  {
+    *(uint8 **)(site + JIT_LINK_TARGET) = block->top;
+    *(uint32 *)(site + JIT_LINK_DELTA) = delta;
+  }
+}
+#endif
+
+#ifdef USE_M68K_PREDECODE
+/* Run the block of instructions starting at PC, decoding them on their first */
+/* run, until the cycle count is reached or PC leaves the decoded path (taken */
+/* branch, exception...). Returns 0 if PC isn't in read-only cartridge ROM.   */
+static int m68ki_run_block(uint cycles)
+{
+  cpu_memory_map *temp = &m68ki_cpu.memory_map[(REG_PC >> 16) & 0xff];
+  const uint8 *base = temp->base;
+  const uint8 *start = base + (REG_PC & 0xffff);
+  m68ki_block_t *block = &m68ki_blocks[((uintptr_t)start >> 1) & (M68K_BLOCKS - 1)];
+  m68ki_decoded_t *insn = block->insn;
+  uint pc;
+
+#if defined(USE_M68K_JIT) && defined(M68K_OVERCLOCK_SHIFT)
+  if (m68ki_jit_ratio != m68ki_cpu.cycle_ratio)
+  {
+    /* Overclock changed: translated code has cycle counts built in */
+    m68k_predecode_flush();
+    m68ki_jit_ratio = m68ki_cpu.cycle_ratio;
+  }
+#endif
+
+  if (block->start != start)
+  {
+    /* ROM pages the CPU can't write directly only (cart.rom also holds the */
+    /* BOOT ROM and cartridge area in Mega CD mode: don't pre-decode there)  */
+    if ((system_hw == SYSTEM_MCD) || (start < cart.rom) || (start >= (cart.rom + cart.romsize)) ||
+        !temp->write8 || !temp->write16)
+    {
+      return 0;
+    }
+
+    block->start = start;
+    block->count = 0;
+#ifdef USE_M68K_JIT
+    block->runs = 0;
+    block->code = NULL;
+    block->top = NULL;
+#endif
+  }
+
+#ifdef USE_M68K_JIT
+  /* Translate hot blocks once fully decoded */
+  if (!block->code && (++block->runs >= M68K_JIT_THRESHOLD) && block->count &&
+      !block->insn[block->count - 1].length)
+  {
+    m68ki_jit_compile(block);
+  }
+
+#ifdef HOOK_CPU
+  /* Execution hook needs every instruction */
+  if (block->code && !cpu_hook)
+#else
+  if (block->code)
+#endif
+  {
+    m68ki_jit_link(block, base);
+    block->code(cycles, &temp->base);
+    return 1;
+  }
+
+  m68ki_jit_exit.site = NULL;
+#endif
+
+  for (;;)
+  {
+    pc = REG_PC;
+
+    if (insn == &block->insn[block->count])
+    {
+      /* First run of this instruction */
+      insn->ir = *(uint16 *)(base + (pc & 0xffff));
+      insn->cycles = CYC_INSTRUCTION[insn->ir];
+      insn->handler = m68ki_instruction_jump_table[insn->ir];
+      insn->length = 0;
+      block->count++;
+
+      REG_IR = insn->ir;
+      REG_PC += 2;
+      insn->handler();
+      USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+
+      /* Block goes on with the next instruction, if it followed this one */
+      /* in the same 64k page (68000 instructions are 10 bytes at most),  */
+      /* unless the handler ran the next one itself (m68k_set_irq_delay) */
+      if (((REG_PC - pc) <= 10) && (REG_PC > pc) && !((REG_PC ^ pc) & 0xff0000) &&
+          (block->count < M68K_BLOCK_INSNS) && (REG_IR == insn->ir))
+      {
+        insn->length = REG_PC - pc;
+      }
+    }
+    else
+    {
+      /* REG_IR is the instruction run last (see m68k_set_irq_delay) */
+      REG_IR = insn->ir;
+      REG_PC += 2;
+      insn->handler();
+      USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+    }
+
+    /* Trace m68k_exception, if necessary */
+    m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+
+    /* Leave on branches, when done, or once the block or page mapping is gone */
+    if (!insn->length || (REG_PC != (pc + insn->length)) || (m68k.cycles >= cycles) ||
+        (block->start != start) || (temp->base != base))
+    {
+      return 1;
+    }
+
+    insn++;
+
+    /* Set tracing accodring to T1. */
+    m68ki_trace_t1() /* auto-disable (see m68kcpu.h) */
+
+    /* Set the address space for reads */
+    m68ki_use_data_space() /* auto-disable (see m68kcpu.h) */
+
+#ifdef HOOK_CPU
+    /* Trigger execution hook */
+    if (cpu_hook)
+      cpu_hook(HOOK_M68K_E, 0, REG_PC, 0);
+#endif
+  }
+}
+#endif
+
 void m68k_run(unsigned int cycles) 
 {
   /* Make sure CPU is not already ahead */
@@ -261,6 +1026,8 @@ void m68k_run(unsigned int cycles)
     return;
   }
 
+  PROFILER_ENTER(PROFILER_M68K);
+
   /* Check interrupt mask to process IRQ if needed */
   m68ki_check_interrupts();
 
@@ -268,6 +1035,7 @@ void m68k_run(unsigned int cycles)
   if (CPU_STOPPED)
   {
     m68k.cycles = cycles;
+    PROFILER_LEAVE();
     return;
   }
 
@@ -295,6 +1063,11 @@ void m68k_run(unsigned int cycles)
       cpu_hook(HOOK_M68K_E, 0, REG_PC, 0);
 #endif
 
+#ifdef USE_M68K_PREDECODE
+    /* Cartridge ROM code runs from pre-decoded blocks */
+    if (m68ki_run_block(cycles)) continue;
+#endif
+
     /* Decode next instruction */
     REG_IR = m68ki_read_imm_16();
 
@@ -305,6 +1078,8 @@ void m68k_run(unsigned int cycles)
     /* Trace m68k_exception, if necessary */
     m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
   }
+
+  PROFILER_LEAVE();
 }
 
 int m68k_cycles(void)
@@ -364,6 +1139,12 @@ void m68k_pulse_reset(void)
   /* Go to supervisor mode */
   m68ki_set_s_flag(SFLAG_SET);
 
+  /* Cartridge ROM may have been reloaded */
+  m68k_predecode_flush();
+
+  /* Memory map has been set up again */
+  m68k_memory_map_update();
+
   /* Invalidate the prefetch queue */
 #if M68K_EMULATE_PREFETCH
   /* Set to arbitrary number since our first fetch is from 0 */
@@ -395,6 +1176,45 @@ void m68k_clear_halt(void)
   CPU_STOPPED &= ~STOP_LEVEL_HALT;
 }
 
+void m68k_predecode_flush(void)
+{
+#ifdef USE_M68K_PREDECODE
+  memset(m68ki_blocks, 0, sizeof(m68ki_blocks));
+#endif
+#ifdef USE_M68K_JIT
+  /* Translated code still running returns on the epoch check */
+  m68ki_jit_used = 0;
+  m68ki_jit_epoch++;
+  m68ki_jit_exit.site = NULL;
+#endif
+}
+
+void m68k_memory_map_update(void)
+{
+  int i;
+
+  for (i = 0; i < 256; i++)
+  {
+    cpu_memory_map *temp = &m68k.memory_map[i];
+    m68k.direct_read[i] = (temp->read8 || temp->read16) ? NULL : temp->base;
+    m68k.direct_write[i] = (temp->write8 || temp->write16) ? NULL : temp->base;
+  }
+}
+
 /* ======================================================================== */
 /* ============================== END OF FILE ============================= */
 /* ======================================================================== */
+
+#ifdef USE_CORE_CONTEXT
+void m68k_context_regions(void)
+{
+  CONTEXT_REGION(m68k);
+  CONTEXT_POINTERS(m68k.memory_map[0].base, 256, sizeof(cpu_memory_map));
+  CONTEXT_POINTERS(m68k.direct_read[0], 256, sizeof(unsigned char *));
+  CONTEXT_POINTERS(m68k.direct_write[0], 256, sizeof(unsigned char *));
+  CONTEXT_REGION(irq_latency);
+#ifdef USE_M68K_PREDECODE
+  CONTEXT_REGION(m68ki_blocks);
+#endif
+}
+#endif
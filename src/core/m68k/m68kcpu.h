@@ -15,6 +15,9 @@
 
 #include "m68k.h"
 
+/* Direct writes to 68K RAM are tracked for incremental snapshots (see state.c) */
+#include "shared.h"
+
 
 /* ======================================================================== */
 /* ============================ GENERAL DEFINES =========================== */
@@ -846,16 +849,24 @@ INLINE uint m68ki_read_imm_32(void)
  * All memory accesses must go through these top level functions.
  * These functions will also check for address error and set the function
  * code if they are enabled in m68kconf.h.
+ * Pages of plain memory are accessed through the direct_read/direct_write
+ * tables first, memory_map is only looked up for pages with handlers.
  */
 INLINE uint m68ki_read_8(uint address)
 {
-  cpu_memory_map *temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
+  uint8 *base = m68ki_cpu.direct_read[((address)>>16)&0xff];
+  cpu_memory_map *temp;
   uint val;
 
   m68ki_set_fc(FLAG_S | m68ki_get_address_space()) /* auto-disable (see m68kcpu.h) */
 
-  if (temp->read8) val = (*temp->read8)(ADDRESS_68K(address));
-  else val = READ_BYTE(temp->base, (address) & 0xffff);
+  if (base) val = READ_BYTE(base, (address) & 0xffff);
+  else
+  {
+    temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
+    if (temp->read8) val = (*temp->read8)(ADDRESS_68K(address));
+    else val = READ_BYTE(temp->base, (address) & 0xffff);
+  }
 
 #ifdef HOOK_CPU
   if (cpu_hook)
@@ -867,15 +878,21 @@ INLINE uint m68ki_read_8(uint address)
 
 INLINE uint m68ki_read_16(uint address)
 {
+  uint8 *base;
   cpu_memory_map *temp;
   uint val;
 
   m68ki_set_fc(FLAG_S | m68ki_get_address_space()) /* auto-disable (see m68kcpu.h) */
   m68ki_check_address_error(address, MODE_READ, FLAG_S | m68ki_get_address_space()) /* auto-disable (see m68kcpu.h) */
   
-  temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
-  if (temp->read16) val = (*temp->read16)(ADDRESS_68K(address));
-  else val = *(uint16 *)(temp->base + ((address) & 0xffff));
+  base = m68ki_cpu.direct_read[((address)>>16)&0xff];
+  if (base) val = *(uint16 *)(base + ((address) & 0xffff));
+  else
+  {
+    temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
+    if (temp->read16) val = (*temp->read16)(ADDRESS_68K(address));
+    else val = *(uint16 *)(temp->base + ((address) & 0xffff));
+  }
 
 #ifdef HOOK_CPU
   if (cpu_hook)
@@ -887,15 +904,25 @@ INLINE uint m68ki_read_16(uint address)
 
 INLINE uint m68ki_read_32(uint address)
 {
+  uint8 *base;
   cpu_memory_map *temp;
   uint val;
 
   m68ki_set_fc(FLAG_S | m68ki_get_address_space()) /* auto-disable (see m68kcpu.h) */
   m68ki_check_address_error(address, MODE_READ, FLAG_S | m68ki_get_address_space()) /* auto-disable (see m68kcpu.h) */
 
-  temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
-  if (temp->read16) val = ((*temp->read16)(ADDRESS_68K(address)) << 16) | ((*temp->read16)(ADDRESS_68K(address + 2)));
-  else val = m68k_read_immediate_32(address);
+  base = m68ki_cpu.direct_read[((address)>>16)&0xff];
+  if (base && (((address) & 0xffff) < 0xfffd))
+  {
+    /* both words are within the same page */
+    val = (*(uint16 *)(base + ((address) & 0xffff)) << 16) | *(uint16 *)(base + ((address) & 0xffff) + 2);
+  }
+  else
+  {
+    temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
+    if (temp->read16) val = ((*temp->read16)(ADDRESS_68K(address)) << 16) | ((*temp->read16)(ADDRESS_68K(address + 2)));
+    else val = m68k_read_immediate_32(address);
+  }
 
 #ifdef HOOK_CPU
   if (cpu_hook)
@@ -907,6 +934,7 @@ INLINE uint m68ki_read_32(uint address)
 
 INLINE void m68ki_write_8(uint address, uint value)
 {
+  uint8 *base;
   cpu_memory_map *temp;
 
   m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_DATA) /* auto-disable (see m68kcpu.h) */
@@ -916,13 +944,24 @@ INLINE void m68ki_write_8(uint address, uint value)
     cpu_hook(HOOK_M68K_W, 1, address, value);
 #endif
 
-  temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
-  if (temp->write8) (*temp->write8)(ADDRESS_68K(address),value);
-  else WRITE_BYTE(temp->base, (address) & 0xffff, value);
+  base = m68ki_cpu.direct_write[((address)>>16)&0xff];
+  if (!base)
+  {
+    temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
+    if (temp->write8) (*temp->write8)(ADDRESS_68K(address),value);
+    else base = temp->base;
+  }
+
+  if (base)
+  {
+    WRITE_BYTE(base, (address) & 0xffff, value);
+    STATE_DIRTY_PTR(base + ((address) & 0xffff));
+  }
 }
 
 INLINE void m68ki_write_16(uint address, uint value)
 {
+  uint8 *base;
   cpu_memory_map *temp;
 
   m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_DATA) /* auto-disable (see m68kcpu.h) */
@@ -933,13 +972,24 @@ INLINE void m68ki_write_16(uint address, uint value)
     cpu_hook(HOOK_M68K_W, 2, address, value);
 #endif
 
-  temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
-  if (temp->write16) (*temp->write16)(ADDRESS_68K(address),value);
-  else *(uint16 *)(temp->base + ((address) & 0xffff)) = value;
+  base = m68ki_cpu.direct_write[((address)>>16)&0xff];
+  if (!base)
+  {
+    temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
+    if (temp->write16) (*temp->write16)(ADDRESS_68K(address),value);
+    else base = temp->base;
+  }
+
+  if (base)
+  {
+    *(uint16 *)(base + ((address) & 0xffff)) = value;
+    STATE_DIRTY_PTR(base + ((address) & 0xffff));
+  }
 }
 
 INLINE void m68ki_write_32(uint address, uint value)
 {
+  uint8 *base;
   cpu_memory_map *temp;
 
   m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_DATA) /* auto-disable (see m68kcpu.h) */
@@ -950,13 +1000,33 @@ INLINE void m68ki_write_32(uint address, uint value)
     cpu_hook(HOOK_M68K_W, 4, address, value);
 #endif
 
-  temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
-  if (temp->write16) (*temp->write16)(ADDRESS_68K(address),value>>16);
-  else *(uint16 *)(temp->base + ((address) & 0xffff)) = value >> 16;
+  base = m68ki_cpu.direct_write[((address)>>16)&0xff];
+  if (!base)
+  {
+    temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
+    if (temp->write16) (*temp->write16)(ADDRESS_68K(address),value>>16);
+    else base = temp->base;
+  }
 
-  temp = &m68ki_cpu.memory_map[((address + 2)>>16)&0xff];
-  if (temp->write16) (*temp->write16)(ADDRESS_68K(address+2),value&0xffff);
-  else *(uint16 *)(temp->base + ((address + 2) & 0xffff)) = value;
+  if (base)
+  {
+    *(uint16 *)(base + ((address) & 0xffff)) = value >> 16;
+    STATE_DIRTY_PTR(base + ((address) & 0xffff));
+  }
+
+  base = m68ki_cpu.direct_write[((address + 2)>>16)&0xff];
+  if (!base)
+  {
+    temp = &m68ki_cpu.memory_map[((address + 2)>>16)&0xff];
+    if (temp->write16) (*temp->write16)(ADDRESS_68K(address+2),value&0xffff);
+    else base = temp->base;
+  }
+
+  if (base)
+  {
+    *(uint16 *)(base + ((address + 2) & 0xffff)) = value;
+    STATE_DIRTY_PTR(base + ((address + 2) & 0xffff));
+  }
 }
 
 
@@ -26,7 +26,7 @@ extern int scd_68k_irq_ack(int level);
 #ifdef BUILD_TABLES
 static unsigned char s68ki_cycles[0x10000];
 #endif
-static int irq_latency;
+static CONTEXT_LOCAL int irq_latency;
 
 /* IRQ priority */
 static const uint8 irq_level[0x40] = 
@@ -41,7 +41,7 @@ static const uint8 irq_level[0x40] =
   6, 6, 6, 6, 6, 6, 6, 6
 };
 
-m68ki_cpu_core s68k;
+CONTEXT_LOCAL m68ki_cpu_core s68k;
 
 
 /* ======================================================================== */
@@ -201,7 +201,7 @@ void s68k_set_fc_callback(void  (*callback)(unsigned int new_fc))
 #endif
 
 extern void error(char *format, ...);
-extern uint16 v_counter;
+extern CONTEXT_LOCAL uint16 v_counter;
 
 /* update IRQ level according to triggered interrupts */
 void s68k_update_irq(unsigned int mask)
@@ -225,6 +225,8 @@ void s68k_run(unsigned int cycles)
     return;
   }
 
+  PROFILER_ENTER(PROFILER_S68K);
+
   /* Check interrupt mask to process IRQ if needed */
   m68ki_check_interrupts();
 
@@ -232,6 +234,7 @@ void s68k_run(unsigned int cycles)
   if (CPU_STOPPED)
   {
     s68k.cycles = cycles;
+    PROFILER_LEAVE();
     return;
   }
 
@@ -263,6 +266,8 @@ void s68k_run(unsigned int cycles)
     /* Trace m68k_exception, if necessary */
     m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
   }
+
+  PROFILER_LEAVE();
 }
 
 
@@ -323,6 +328,9 @@ void s68k_pulse_reset(void)
   /* Go to supervisor mode */
   m68ki_set_s_flag(SFLAG_SET);
 
+  /* Memory map has been set up again */
+  s68k_memory_map_update();
+
   /* Invalidate the prefetch queue */
 #if M68K_EMULATE_PREFETCH
   /* Set to arbitrary number since our first fetch is from 0 */
@@ -354,6 +362,29 @@ void s68k_clear_halt()
   CPU_STOPPED &= ~STOP_LEVEL_HALT;
 }
 
+void s68k_memory_map_update(void)
+{
+  int i;
+
+  for (i = 0; i < 256; i++)
+  {
+    cpu_memory_map *temp = &s68k.memory_map[i];
+    s68k.direct_read[i] = (temp->read8 || temp->read16) ? NULL : temp->base;
+    s68k.direct_write[i] = (temp->write8 || temp->write16) ? NULL : temp->base;
+  }
+}
+
 /* ======================================================================== */
 /* ============================== END OF FILE ============================= */
 /* ======================================================================== */
+
+#ifdef USE_CORE_CONTEXT
+void s68k_context_regions(void)
+{
+  CONTEXT_REGION(s68k);
+  CONTEXT_POINTERS(s68k.memory_map[0].base, 256, sizeof(cpu_memory_map));
+  CONTEXT_POINTERS(s68k.direct_read[0], 256, sizeof(unsigned char *));
+  CONTEXT_POINTERS(s68k.direct_write[0], 256, sizeof(unsigned char *));
+  CONTEXT_REGION(irq_latency);
+}
+#endif
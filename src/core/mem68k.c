@@ -207,6 +207,7 @@ void z80_write_byte(unsigned int address, unsigned int data)
     default: /* ZRAM */
     {
       zram[address & 0x1FFF] = data;
+      STATE_DIRTY_ZRAM(address);
       m68k.cycles += 2 * 7; /* ZRAM access latency (fixes Pacman 2: New Adventures & Puyo Puyo 2) */
       return;
     }
@@ -746,6 +747,8 @@ void ctrl_io_write_byte(unsigned int address, unsigned int data)
                 zbank_memory_map[base].read   = zbank_memory_map[base+1].read   = zbank_unused_r;
                 zbank_memory_map[base].write  = zbank_memory_map[base+1].write  = zbank_unused_w;
               }
+
+              m68k_memory_map_update();
             }
 
             scd.regs[0x00].byte.l = data;
@@ -765,6 +768,7 @@ void ctrl_io_write_byte(unsigned int address, unsigned int data)
             /* PRG-RAM 128k bank mapped to $020000-$03FFFF (resp. $420000-$43FFFF) */
             m68k.memory_map[scd.cartridge.boot + 0x02].base = scd.prg_ram + ((data & 0xc0) << 11);
             m68k.memory_map[scd.cartridge.boot + 0x03].base = m68k.memory_map[scd.cartridge.boot + 0x02].base + 0x10000;
+            m68k_memory_map_update();
 
             /* check current mode */
             if (scd.regs[0x03>>1].byte.l & 0x04)
@@ -971,6 +975,8 @@ void ctrl_io_write_word(unsigned int address, unsigned int data)
                 zbank_memory_map[base].read   = zbank_memory_map[base+1].read   = zbank_unused_r;
                 zbank_memory_map[base].write  = zbank_memory_map[base+1].write  = zbank_unused_w;
               }
+
+              m68k_memory_map_update();
             }
 
             /* IFL2 bit */
@@ -1002,6 +1008,7 @@ void ctrl_io_write_word(unsigned int address, unsigned int data)
             /* PRG-RAM 128k bank mapped to $020000-$03FFFF (resp. $420000-$43FFFF) */
             m68k.memory_map[scd.cartridge.boot + 0x02].base = scd.prg_ram + ((data & 0xc0) << 11);
             m68k.memory_map[scd.cartridge.boot + 0x03].base = m68k.memory_map[scd.cartridge.boot + 0x02].base + 0x10000;
+            m68k_memory_map_update();
 
             /* check current mode */
             if (scd.regs[0x03>>1].byte.l & 0x04)
@@ -54,6 +54,6 @@ struct _zbank_memory_map
   unsigned int (*read)(unsigned int address);
   void (*write)(unsigned int address, unsigned int data);
 };
-extern struct _zbank_memory_map zbank_memory_map[256];
+extern CONTEXT_LOCAL struct _zbank_memory_map zbank_memory_map[256];
 
 #endif /* _MEMBNK_H_ */
@@ -41,7 +41,7 @@
 
 #include "shared.h"
 
-struct _zbank_memory_map zbank_memory_map[256];
+CONTEXT_LOCAL struct _zbank_memory_map zbank_memory_map[256];
 
 /*--------------------------------------------------------------------------*/
 /*  Handlers for access to unused addresses and those which make the        */
@@ -95,11 +95,22 @@ INLINE unsigned char z80_lockup_r(unsigned int address)
 
 unsigned char z80_memory_r(unsigned int address)
 {
+#ifdef USE_Z80_IDLE_SKIP
+  /* hardware reads end idle loop detection */
+  if (address & 0xC000)
+  {
+    z80_poll_address = Z80_POLL_NONE;
+  }
+#endif
+
   switch((address >> 13) & 7)
   {
     case 0: /* $0000-$3FFF: Z80 RAM (8K mirrored) */
     case 1:
     {
+#ifdef USE_Z80_IDLE_SKIP
+      z80_poll_detect(address & 0x1FFF);
+#endif
       return zram[address & 0x1FFF];
     }
 
@@ -132,12 +143,18 @@ unsigned char z80_memory_r(unsigned int address)
 
 void z80_memory_w(unsigned int address, unsigned char data)
 {
+#ifdef USE_Z80_IDLE_SKIP
+  /* any write ends idle loop detection */
+  z80_poll_address = Z80_POLL_NONE;
+#endif
+
   switch((address >> 13) & 7)
   {
     case 0: /* $0000-$3FFF: Z80 RAM (8K mirrored) */
     case 1: 
     {
       zram[address & 0x1FFF] = data;
+      STATE_DIRTY_ZRAM(address);
       return;
     }
 
@@ -180,6 +197,7 @@ void z80_memory_w(unsigned int address, unsigned char data)
         return;
       }
       WRITE_BYTE(m68k.memory_map[address >> 16].base, address & 0xFFFF, data);
+      STATE_DIRTY_PTR(m68k.memory_map[address >> 16].base + (address & 0xFFFF));
       return;
     }
   }
@@ -753,3 +771,10 @@ unsigned char z80_sg_port_r(unsigned int port)
     }
   }
 }
+
+#ifdef USE_CORE_CONTEXT
+void memz80_context_regions(void)
+{
+  CONTEXT_REGION(zbank_memory_map);
+}
+#endif
@@ -9,6 +9,7 @@
 #include "types.h"
 #include "osd.h"
 #include "macros.h"
+#include "context.h"
 #include "loadrom.h"
 #include "m68k.h"
 #include "z80.h"
@@ -36,6 +37,7 @@
 #include "areplay.h"
 #include "svp.h"
 #include "state.h"
+#include "profiler.h"
 
 extern int running;
 extern void *window_shared;
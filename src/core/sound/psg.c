@@ -74,7 +74,7 @@ static const uint16 chanVolume[16] = {
   0                             /*  OFF  */
 };
 
-static struct
+static CONTEXT_LOCAL struct
 {
   int clocks;
   int latch;
@@ -567,3 +567,10 @@ static void psg_update(unsigned int clocks)
     psg.polarity[i] = polarity;
   }
 }  
+
+#ifdef USE_CORE_CONTEXT
+void psg_context_regions(void)
+{
+  CONTEXT_REGION(psg);
+}
+#endif
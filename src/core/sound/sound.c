@@ -45,39 +45,39 @@
 
 /* FM output buffer (large enough to hold a whole frame at original chips rate) */
 #if defined(HAVE_YM3438_CORE) || defined(HAVE_OPLL_CORE)
-static int fm_buffer[1080 * 2 * 24];
+static CONTEXT_LOCAL int fm_buffer[1080 * 2 * 24];
 #else
-static int fm_buffer[1080 * 2];
+static CONTEXT_LOCAL int fm_buffer[1080 * 2];
 #endif
 
-static int fm_last[2];
-static int *fm_ptr;
+static CONTEXT_LOCAL int fm_last[2];
+static CONTEXT_LOCAL int *fm_ptr;
 
 /* Cycle-accurate FM samples */
-static int fm_cycles_ratio;
-static int fm_cycles_start;
-static int fm_cycles_count;
-static int fm_cycles_busy;
+static CONTEXT_LOCAL int fm_cycles_ratio;
+static CONTEXT_LOCAL int fm_cycles_start;
+static CONTEXT_LOCAL int fm_cycles_count;
+static CONTEXT_LOCAL int fm_cycles_busy;
 
 /* YM chip function pointers */
-static void (*YM_Update)(int *buffer, int length);
-void (*fm_reset)(unsigned int cycles);
-void (*fm_write)(unsigned int cycles, unsigned int address, unsigned int data);
-unsigned int (*fm_read)(unsigned int cycles, unsigned int address);
+static CONTEXT_LOCAL void (*YM_Update)(int *buffer, int length);
+CONTEXT_LOCAL void (*fm_reset)(unsigned int cycles);
+CONTEXT_LOCAL void (*fm_write)(unsigned int cycles, unsigned int address, unsigned int data);
+CONTEXT_LOCAL unsigned int (*fm_read)(unsigned int cycles, unsigned int address);
 
 #ifdef HAVE_YM3438_CORE
-static ym3438_t ym3438;
-static short ym3438_accm[24][2];
-static int ym3438_sample[2];
-static int ym3438_cycles;
+static CONTEXT_LOCAL ym3438_t ym3438;
+static CONTEXT_LOCAL short ym3438_accm[24][2];
+static CONTEXT_LOCAL int ym3438_sample[2];
+static CONTEXT_LOCAL int ym3438_cycles;
 #endif
 
 #ifdef HAVE_OPLL_CORE
-static opll_t opll;
-static int opll_accm[18][2];
-static int opll_sample;
-static int opll_cycles;
-static int opll_status;
+static CONTEXT_LOCAL opll_t opll;
+static CONTEXT_LOCAL int opll_accm[18][2];
+static CONTEXT_LOCAL int opll_sample;
+static CONTEXT_LOCAL int opll_cycles;
+static CONTEXT_LOCAL int opll_status;
 #endif
 
 /* Run FM chip until required M-cycles */
@@ -562,3 +562,34 @@ int sound_context_load(uint8 *state)
 
   return bufferptr;
 }
+
+#ifdef USE_CORE_CONTEXT
+void sound_context_regions(void)
+{
+  CONTEXT_REGION(fm_buffer);
+  CONTEXT_REGION(fm_last);
+  CONTEXT_REGION(fm_ptr);
+  CONTEXT_POINTERS(fm_ptr, 1, sizeof(fm_ptr));
+  CONTEXT_REGION(fm_cycles_ratio);
+  CONTEXT_REGION(fm_cycles_start);
+  CONTEXT_REGION(fm_cycles_count);
+  CONTEXT_REGION(fm_cycles_busy);
+  CONTEXT_REGION(YM_Update);
+  CONTEXT_REGION(fm_reset);
+  CONTEXT_REGION(fm_write);
+  CONTEXT_REGION(fm_read);
+#ifdef HAVE_YM3438_CORE
+  CONTEXT_REGION(ym3438);
+  CONTEXT_REGION(ym3438_accm);
+  CONTEXT_REGION(ym3438_sample);
+  CONTEXT_REGION(ym3438_cycles);
+#endif
+#ifdef HAVE_OPLL_CORE
+  CONTEXT_REGION(opll);
+  CONTEXT_REGION(opll_accm);
+  CONTEXT_REGION(opll_sample);
+  CONTEXT_REGION(opll_cycles);
+  CONTEXT_REGION(opll_status);
+#endif
+}
+#endif
@@ -496,13 +496,13 @@ static unsigned char table[19][8] = {
   {0x05, 0x01, 0x00, 0x00, 0xf8, 0xba, 0x49, 0x55 },/* TOM(multi,env verified), TOP CYM(multi verified, env verified) */
 };
 
-static signed int output[2];
+static CONTEXT_LOCAL signed int output[2];
 
-static UINT32  LFO_AM;
-static INT32  LFO_PM;
+static CONTEXT_LOCAL UINT32  LFO_AM;
+static CONTEXT_LOCAL INT32  LFO_PM;
 
 /* emulated chip */
-static YM2413 ym2413;
+static CONTEXT_LOCAL YM2413 ym2413;
 
 /* advance LFO to next sample */
 INLINE void advance_lfo(void)
@@ -1719,3 +1719,13 @@ unsigned int YM2413GetContextSize(void)
 {
   return sizeof(YM2413);
 }
+
+#ifdef USE_CORE_CONTEXT
+void ym2413_context_regions(void)
+{
+  CONTEXT_REGION(ym2413);
+  CONTEXT_REGION(output);
+  CONTEXT_REGION(LFO_AM);
+  CONTEXT_REGION(LFO_PM);
+}
+#endif
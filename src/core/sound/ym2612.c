@@ -622,16 +622,16 @@ typedef struct
 } YM2612;
 
 /* emulated chip */
-static YM2612 ym2612;
+static CONTEXT_LOCAL YM2612 ym2612;
 
 /* current chip state */
-static INT32  m2,c1,c2;   /* Phase Modulation input for operators 2,3,4 */
-static INT32  mem;        /* one sample delay memory */
-static INT32  out_fm[6];  /* outputs of working channels */
+static CONTEXT_LOCAL INT32  m2,c1,c2;   /* Phase Modulation input for operators 2,3,4 */
+static CONTEXT_LOCAL INT32  mem;        /* one sample delay memory */
+static CONTEXT_LOCAL INT32  out_fm[6];  /* outputs of working channels */
 
 /* chip type */
-static UINT32 op_mask[8][4];  /* operator output bitmasking (DAC quantization) */
-static int chip_type = YM2612_DISCRETE;
+static CONTEXT_LOCAL UINT32 op_mask[8][4];  /* operator output bitmasking (DAC quantization) */
+static CONTEXT_LOCAL int chip_type = YM2612_DISCRETE;
 
 
 INLINE void FM_KEYON(FM_CH *CH , int s )
@@ -2255,3 +2255,28 @@ int YM2612SaveContext(unsigned char *state)
 
   return bufferptr;
 }
+
+#ifdef USE_CORE_CONTEXT
+void ym2612_context_regions(void)
+{
+  int c;
+
+  CONTEXT_REGION(ym2612);
+  CONTEXT_REGION(m2);
+  CONTEXT_REGION(c1);
+  CONTEXT_REGION(c2);
+  CONTEXT_REGION(mem);
+  CONTEXT_REGION(out_fm);
+  CONTEXT_REGION(op_mask);
+  CONTEXT_REGION(chip_type);
+
+  /* operator connections and detune tables point into the above */
+  CONTEXT_POINTERS(ym2612.CH[0].connect1, 6, sizeof(FM_CH));
+  CONTEXT_POINTERS(ym2612.CH[0].connect2, 6, sizeof(FM_CH));
+  CONTEXT_POINTERS(ym2612.CH[0].connect3, 6, sizeof(FM_CH));
+  CONTEXT_POINTERS(ym2612.CH[0].connect4, 6, sizeof(FM_CH));
+  CONTEXT_POINTERS(ym2612.CH[0].mem_connect, 6, sizeof(FM_CH));
+  for (c = 0; c < 6; c++)
+    CONTEXT_POINTERS(ym2612.CH[c].SLOT[0].DT, 4, sizeof(FM_SLOT));
+}
+#endif
@@ -38,15 +38,126 @@
 
 #include "shared.h"
 
+/*
+ *  Incremental snapshots
+ *
+ *  Rewind & rollback take a snapshot every frame, while most frames only touch a
+ *  few pages of 68K RAM, Z80 RAM and VRAM. Writes to these are tracked with one
+ *  dirty flag per 4 KB page (CPU direct writes, Z80 & 68K bus handlers, VDP data
+ *  port & DMA), and state_delta_save serializes the usual state with only the
+ *  pages written since the previous snapshot. Everything else (registers, CRAM,
+ *  sound chips, cartridge & CD hardware) is small or not tracked, and is saved
+ *  in full every time.
+ *
+ *  A snapshot taken with keyframe set holds all pages. A later state is restored
+ *  by loading the last keyframe before it, then each following snapshot in order.
+ *  Snapshots are written into the caller's buffer (up to STATE_SIZE bytes), so
+ *  nothing is allocated per frame.
+ */
+
+CONTEXT_LOCAL uint8 state_dirty[STATE_PAGES];
+
+/* set while state_load/state_save handle an incremental snapshot */
+static CONTEXT_LOCAL int state_delta;
+
+/* tracked memory kept across system reset while an incremental snapshot is loaded */
+static CONTEXT_LOCAL uint8 state_stash[sizeof(work_ram) + sizeof(zram) + sizeof(vram)];
+
+void state_dirty_all(void)
+{
+  memset(state_dirty, 1, sizeof(state_dirty));
+}
+
+int state_save_pages(unsigned char *state, int page, const uint8 *base, int size)
+{
+  int offset, length, bufferptr = 0;
+
+  if (!state_delta)
+  {
+    save_param(base, size);
+    return bufferptr;
+  }
+
+  /* one flag per page, followed by the page if it was written */
+  for (offset = 0; offset < size; offset += STATE_PAGE_SIZE, page++)
+  {
+    state[bufferptr++] = state_dirty[page];
+    if (state_dirty[page])
+    {
+      length = ((size - offset) < STATE_PAGE_SIZE) ? (size - offset) : STATE_PAGE_SIZE;
+      save_param(base + offset, length);
+    }
+  }
+
+  return bufferptr;
+}
+
+int state_load_pages(unsigned char *state, int page, uint8 *base, int size)
+{
+  int offset, length, bufferptr = 0;
+
+  if (!state_delta)
+  {
+    load_param(base, size);
+    return bufferptr;
+  }
+
+  for (offset = 0; offset < size; offset += STATE_PAGE_SIZE, page++)
+  {
+    if (state[bufferptr++])
+    {
+      length = ((size - offset) < STATE_PAGE_SIZE) ? (size - offset) : STATE_PAGE_SIZE;
+      load_param(base + offset, length);
+    }
+  }
+
+  return bufferptr;
+}
+
+int state_delta_save(unsigned char *state, int keyframe)
+{
+  int size;
+
+  if (keyframe)
+  {
+    state_dirty_all();
+  }
+
+  state_delta = 1;
+  size = state_save(state);
+  state_delta = 0;
+
+  /* next snapshot only holds what is written from now on */
+  memset(state_dirty, 0, sizeof(state_dirty));
+  return size;
+}
+
+int state_delta_load(unsigned char *state)
+{
+  int size;
+
+  state_delta = 1;
+  size = state_load(state);
+  state_delta = 0;
+
+  /* tracked memory now matches the snapshot */
+  if (size)
+  {
+    memset(state_dirty, 0, sizeof(state_dirty));
+  }
+
+  return size;
+}
+
 int state_load(unsigned char *state)
 {
   int i, bufferptr = 0;
 
-  /* signature check (GENPLUS-GX x.x.x) */
+  /* signature check (GENPLUS-GX x.x.x or GPGX-DELTA x.x.x) */
   char version[17];
   load_param(version,16);
   version[16] = 0;
-  if (memcmp(version,STATE_VERSION,11))
+  if (memcmp(version,state_delta ? STATE_DELTA : STATE_VERSION,11))
   {
     return 0;
   }
@@ -57,9 +168,24 @@ int state_load(unsigned char *state)
     return 0;
   }
 
+  /* pages missing from an incremental snapshot must survive system reset */
+  if (state_delta)
+  {
+    memcpy(state_stash, work_ram, sizeof(work_ram));
+    memcpy(state_stash + sizeof(work_ram), zram, sizeof(zram));
+    memcpy(state_stash + sizeof(work_ram) + sizeof(zram), vram, sizeof(vram));
+  }
+
   /* reset system */
   system_reset();
 
+  if (state_delta)
+  {
+    memcpy(work_ram, state_stash, sizeof(work_ram));
+    memcpy(zram, state_stash + sizeof(work_ram), sizeof(zram));
+    memcpy(vram, state_stash + sizeof(work_ram) + sizeof(zram), sizeof(vram));
+  }
+
   /* enable VDP access for TMSS systems */
   for (i=0xc0; i<0xe0; i+=8)
   {
@@ -74,8 +200,8 @@ int state_load(unsigned char *state)
   /* GENESIS */
   if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
   {
-    load_param(work_ram, sizeof(work_ram));
-    load_param(zram, sizeof(zram));
+    bufferptr += state_load_pages(&state[bufferptr], STATE_PAGES_WRAM, work_ram, sizeof(work_ram));
+    bufferptr += state_load_pages(&state[bufferptr], STATE_PAGES_ZRAM, zram, sizeof(zram));
     load_param(&zstate, sizeof(zstate));
     load_param(&zbank, sizeof(zbank));
     if (zstate == 3)
@@ -95,7 +221,7 @@ int state_load(unsigned char *state)
   }
   else
   {
-    load_param(work_ram, 0x2000);
+    bufferptr += state_load_pages(&state[bufferptr], STATE_PAGES_WRAM, work_ram, 0x2000);
   }
 
   /* IO */
@@ -187,6 +313,10 @@ int state_load(unsigned char *state)
     sms_cart_switch(~io_reg[0x0E]);
   }
 
+  /* 68k memory maps have been restored */
+  m68k_memory_map_update();
+  s68k_memory_map_update();
+
   return bufferptr;
 }
 
@@ -197,20 +327,20 @@ int state_save(unsigned char *state)
 
   /* version string */
   char version[16];
-  memcpy(version,STATE_VERSION,16);
+  memcpy(version,state_delta ? STATE_DELTA : STATE_VERSION,16);
   save_param(version, 16);
 
   /* GENESIS */
   if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
   {
-    save_param(work_ram, sizeof(work_ram));
-    save_param(zram, sizeof(zram));
+    bufferptr += state_save_pages(&state[bufferptr], STATE_PAGES_WRAM, work_ram, sizeof(work_ram));
+    bufferptr += state_save_pages(&state[bufferptr], STATE_PAGES_ZRAM, zram, sizeof(zram));
     save_param(&zstate, sizeof(zstate));
     save_param(&zbank, sizeof(zbank));
   }
   else
   {
-    save_param(work_ram, 0x2000);
+    bufferptr += state_save_pages(&state[bufferptr], STATE_PAGES_WRAM, work_ram, 0x2000);
   }
 
   /* IO */
@@ -281,3 +411,10 @@ int state_save(unsigned char *state)
   /* return total size */
   return bufferptr;
 }
+
+#ifdef USE_CORE_CONTEXT
+void state_context_regions(void)
+{
+  CONTEXT_REGION(state_dirty);
+}
+#endif
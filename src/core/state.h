@@ -41,6 +41,15 @@
 
 #define STATE_SIZE    0xfd000
 #define STATE_VERSION "GENPLUS-GX 1.7.5"
+#define STATE_DELTA   "GPGX-DELTA 1.7.5"
+
+/* Dirty page tracking (incremental snapshots) */
+#define STATE_PAGE_SHIFT  12
+#define STATE_PAGE_SIZE   (1 << STATE_PAGE_SHIFT)
+#define STATE_PAGES_WRAM  0   /* 68K RAM (16 pages) */
+#define STATE_PAGES_ZRAM  16  /* Z80 RAM (2 pages) */
+#define STATE_PAGES_VRAM  18  /* VDP VRAM (16 pages) */
+#define STATE_PAGES       34
 
 #define load_param(param, size) \
   memcpy(param, &state[bufferptr], size); \
@@ -50,8 +59,30 @@
   memcpy(&state[bufferptr], param, size); \
   bufferptr+= size;
 
+/* Mark the 68K RAM page written through a CPU memory map pointer (other memory is ignored) */
+#define STATE_DIRTY_PTR(ptr) \
+{ \
+  size_t dirty_offset = (uint8 *)(ptr) - work_ram; \
+  if (dirty_offset < sizeof(work_ram)) state_dirty[STATE_PAGES_WRAM + (dirty_offset >> STATE_PAGE_SHIFT)] = 1; \
+}
+
+#define STATE_DIRTY_ZRAM(addr) state_dirty[STATE_PAGES_ZRAM + (((addr) & 0x1FFF) >> STATE_PAGE_SHIFT)] = 1
+#define STATE_DIRTY_VRAM(addr) state_dirty[STATE_PAGES_VRAM + (((addr) & 0xFFFF) >> STATE_PAGE_SHIFT)] = 1
+
+/* Global variables */
+extern CONTEXT_LOCAL uint8 state_dirty[STATE_PAGES];
+
 /* Function prototypes */
 extern int state_load(unsigned char *state);
 extern int state_save(unsigned char *state);
 
+/* Incremental snapshots (see state.c) */
+extern int state_delta_load(unsigned char *state);
+extern int state_delta_save(unsigned char *state, int keyframe);
+
+/* Tracked memory in (incremental) snapshots */
+extern int state_load_pages(unsigned char *state, int page, uint8 *base, int size);
+extern int state_save_pages(unsigned char *state, int page, const uint8 *base, int size);
+extern void state_dirty_all(void);
+
 #endif
@@ -43,17 +43,17 @@
 #include "eq.h"
 
 /* Global variables */
-t_bitmap bitmap;
-t_snd snd;
-uint32 mcycles_vdp;
-uint8 system_hw;
-uint8 system_bios = 0;
-uint32 system_clock;
-int16 SVP_cycles = 800; 
-
-static uint8 pause_b;
-static EQSTATE eq[2];
-static int16 llp,rrp;
+CONTEXT_LOCAL t_bitmap bitmap;
+CONTEXT_LOCAL t_snd snd;
+CONTEXT_LOCAL uint32 mcycles_vdp;
+CONTEXT_LOCAL uint8 system_hw;
+CONTEXT_LOCAL uint8 system_bios = 0;
+CONTEXT_LOCAL uint32 system_clock;
+CONTEXT_LOCAL int16 SVP_cycles = 800; 
+
+static CONTEXT_LOCAL uint8 pause_b;
+static CONTEXT_LOCAL EQSTATE eq[2];
+static CONTEXT_LOCAL int16 llp,rrp;
 
 /******************************************************************************************/
 /* Audio subsystem                                                                        */
@@ -192,8 +192,12 @@ void audio_shutdown(void)
 
 int audio_update(int16 *buffer)
 {
+  int size;
+
+  PROFILER_ENTER(PROFILER_SOUND);
+
   /* run sound chips until end of frame */
-  int size = sound_update(mcycles_vdp);
+  size = sound_update(mcycles_vdp);
 
   /* Mega CD specific */
   if (system_hw == SYSTEM_MCD)
@@ -210,7 +214,9 @@ int audio_update(int16 *buffer)
 #endif
 
     /* resample & mix FM/PSG, PCM & CD-DA streams to output buffer */
+    PROFILER_ENTER(PROFILER_BLIP);
     blip_mix_samples(snd.blips[0], snd.blips[1], snd.blips[2], buffer, size);
+    PROFILER_LEAVE();
   }
   else
   {
@@ -220,7 +226,9 @@ int audio_update(int16 *buffer)
 #endif
 
     /* resample FM/PSG mixed stream to output buffer */
+    PROFILER_ENTER(PROFILER_BLIP);
     blip_read_samples(snd.blips[0], buffer, size);
+    PROFILER_LEAVE();
   }
 
   /* Audio filtering */
@@ -300,6 +308,8 @@ int audio_update(int16 *buffer)
   error("%d samples returned\n\n",size);
 #endif
 
+  PROFILER_LEAVE();
+
   return size;
 }
 
@@ -323,6 +333,9 @@ void system_reset(void)
   vdp_reset();
   sound_reset();
   audio_reset();
+
+  /* everything changed since the previous incremental snapshot */
+  state_dirty_all();
 }
 
 void system_frame_gen(int do_skip)
@@ -337,6 +350,10 @@ void system_frame_gen(int do_skip)
   fifo_write_cnt = 0;
   fifo_slots = 0;
 
+  /* frontend may have switched framebuffers, GPU lines are captured anew */
+  RENDER_DIRTY_BEGIN();
+  RENDER_GPU_BEGIN();
+
   /* check if display setings have changed during previous frame */
   if (bitmap.viewport.changed & 2)
   {
@@ -401,7 +418,7 @@ void system_frame_gen(int do_skip)
     }
 
     /* active screen width */
-    bitmap.viewport.w = 400;
+    bitmap.viewport.w = config_legacy.screen_width;
 
     /* check viewport changes */
     if (bitmap.viewport.h != bitmap.viewport.oh)
@@ -566,7 +583,7 @@ void system_frame_gen(int do_skip)
   /* parse first line of sprites */
   if (reg[1] & 0x40)
   {
-    parse_satb(-1);
+    PARSE_SATB(-1);
   }
 
   /* update 6-Buttons & Lightguns */
@@ -606,12 +623,12 @@ void system_frame_gen(int do_skip)
     /* render scanline */
     if (!do_skip)
     {
-      render_line(line);
+      RENDER_LINE(line);
 
       // Bye bye interlacing
       if (interlaced) {
         odd_frame ^= 1;
-        render_line(line);
+        RENDER_LINE(line);
         odd_frame ^= 1;
       }
     }
@@ -657,6 +674,9 @@ void system_frame_gen(int do_skip)
   }
   while (++line < bitmap.viewport.h);
 
+  /* render lines still queued */
+  RENDER_SYNC();
+
   /* check viewport changes */
   if (bitmap.viewport.w != bitmap.viewport.ow)
   {
@@ -683,6 +703,10 @@ void system_frame_scd(int do_skip)
   fifo_write_cnt = 0;
   fifo_slots = 0;
 
+  /* frontend may have switched framebuffers, GPU lines are captured anew */
+  RENDER_DIRTY_BEGIN();
+  RENDER_GPU_BEGIN();
+
   /* check if display setings have changed during previous frame */
   if (bitmap.viewport.changed & 2)
   {
@@ -904,7 +928,7 @@ void system_frame_scd(int do_skip)
   /* parse first line of sprites */
   if (reg[1] & 0x40)
   {
-    parse_satb(-1);
+    PARSE_SATB(-1);
   }
 
   /* update 6-Buttons & Lightguns */
@@ -940,7 +964,7 @@ void system_frame_scd(int do_skip)
     /* render scanline */
     if (!do_skip)
     {
-      render_line(line);
+      RENDER_LINE(line);
     }
     
     /* update 6-Buttons & Lightguns */
@@ -980,6 +1004,9 @@ void system_frame_scd(int do_skip)
   }
   while (++line < bitmap.viewport.h);
 
+  /* render lines still queued */
+  RENDER_SYNC();
+
   /* check viewport changes */
   if (bitmap.viewport.w != bitmap.viewport.ow)
   {
@@ -1006,6 +1033,10 @@ void system_frame_sms(int do_skip)
   fifo_write_cnt = 0;
   fifo_slots = 0;
 
+  /* frontend may have switched framebuffers, GPU lines are captured anew */
+  RENDER_DIRTY_BEGIN();
+  RENDER_GPU_BEGIN();
+
   /* check if display settings has changed during previous frame */
   if (bitmap.viewport.changed & 2)
   {
@@ -1397,3 +1428,20 @@ void system_frame_sms(int do_skip)
   input_end_frame(mcycles_vdp);
   Z80.cycles -= mcycles_vdp;
 }
+
+#ifdef USE_CORE_CONTEXT
+void system_context_regions(void)
+{
+  CONTEXT_REGION(bitmap);
+  CONTEXT_REGION(snd);
+  CONTEXT_REGION(mcycles_vdp);
+  CONTEXT_REGION(system_hw);
+  CONTEXT_REGION(system_bios);
+  CONTEXT_REGION(system_clock);
+  CONTEXT_REGION(SVP_cycles);
+  CONTEXT_REGION(pause_b);
+  CONTEXT_REGION(eq);
+  CONTEXT_REGION(llp);
+  CONTEXT_REGION(rrp);
+}
+#endif
@@ -96,13 +96,13 @@ typedef struct
 
 
 /* Global variables */
-extern t_bitmap bitmap;
-extern t_snd snd;
-extern uint32 mcycles_vdp;
-extern int16 SVP_cycles; 
-extern uint8 system_hw;
-extern uint8 system_bios;
-extern uint32 system_clock;
+extern CONTEXT_LOCAL t_bitmap bitmap;
+extern CONTEXT_LOCAL t_snd snd;
+extern CONTEXT_LOCAL uint32 mcycles_vdp;
+extern CONTEXT_LOCAL int16 SVP_cycles; 
+extern CONTEXT_LOCAL uint8 system_hw;
+extern CONTEXT_LOCAL uint8 system_bios;
+extern CONTEXT_LOCAL uint32 system_clock;
 
 #ifdef __cplusplus
 extern "C" {
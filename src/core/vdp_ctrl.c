@@ -42,9 +42,10 @@
 #include "shared.h"
 #include "hvc.h"
 
-/* Mark a pattern as modified */
+/* Mark a pattern (and its VRAM page) as modified */
 #define MARK_BG_DIRTY(addr)                         \
 {                                                   \
+  STATE_DIRTY_VRAM(addr);                           \
   name = (addr >> 5) & 0x7FF;                       \
   if (bg_name_dirty[name] == 0)                     \
   {                                                 \
@@ -53,50 +54,70 @@
   bg_name_dirty[name] |= (1 << ((addr >> 2) & 7));  \
 }
 
+/* Update internal SAT (Y position, size & link changes invalidate the sprite line index) */
+#define WRITE_SAT_WORD(offset, data)                \
+{                                                   \
+  uint16 *sat_word = (uint16 *)&sat[offset];        \
+  if (!((offset) & 4) && (*sat_word != (data)))     \
+  {                                                 \
+    sprite_index_dirty = 1;                         \
+  }                                                 \
+  *sat_word = data;                                 \
+}
+
+#define WRITE_SAT_BYTE(offset, data)                \
+{                                                   \
+  if (!((offset) & 4) && (READ_BYTE(sat, offset) != (data))) \
+  {                                                 \
+    sprite_index_dirty = 1;                         \
+  }                                                 \
+  WRITE_BYTE(sat, offset, data);                    \
+}
+
 /* VDP context */
-uint8 ALIGNED_(4) sat[0x400];    /* Internal copy of sprite attribute table */
-uint8 ALIGNED_(4) vram[0x10000]; /* Video RAM (64K x 8-bit) */
-uint8 ALIGNED_(4) cram[0x80];    /* On-chip color RAM (64 x 9-bit) */
-uint8 ALIGNED_(4) vsram[0x80];   /* On-chip vertical scroll RAM (40 x 11-bit) */
-uint8 reg[0x20];                 /* Internal VDP registers (23 x 8-bit) */
-uint8 hint_pending;              /* 0= Line interrupt is pending */
-uint8 vint_pending;              /* 1= Frame interrupt is pending */
-uint16 status;                   /* VDP status flags */
-uint32 dma_length;               /* DMA remaining length */
+CONTEXT_LOCAL uint8 ALIGNED_(4) sat[0x400];    /* Internal copy of sprite attribute table */
+CONTEXT_LOCAL uint8 ALIGNED_(4) vram[0x10000]; /* Video RAM (64K x 8-bit) */
+CONTEXT_LOCAL uint8 ALIGNED_(4) cram[0x80];    /* On-chip color RAM (64 x 9-bit) */
+CONTEXT_LOCAL uint8 ALIGNED_(4) vsram[0x80];   /* On-chip vertical scroll RAM (40 x 11-bit) */
+CONTEXT_LOCAL uint8 reg[0x20];                 /* Internal VDP registers (23 x 8-bit) */
+CONTEXT_LOCAL uint8 hint_pending;              /* 0= Line interrupt is pending */
+CONTEXT_LOCAL uint8 vint_pending;              /* 1= Frame interrupt is pending */
+CONTEXT_LOCAL uint16 status;                   /* VDP status flags */
+CONTEXT_LOCAL uint32 dma_length;               /* DMA remaining length */
 
 /* Global variables */
-uint16 ntab;                      /* Name table A base address */
-uint16 ntbb;                      /* Name table B base address */
-uint16 ntwb;                      /* Name table W base address */
-uint16 satb;                      /* Sprite attribute table base address */
-uint16 hscb;                      /* Horizontal scroll table base address */
-uint8 bg_name_dirty[0x800];       /* 1= This pattern is dirty */
-uint16 bg_name_list[0x800];       /* List of modified pattern indices */
-uint16 bg_list_index;             /* # of modified patterns in list */
-uint8 hscroll_mask;               /* Horizontal Scrolling line mask */
-uint8 playfield_shift;            /* Width of planes A, B (in bits) */
-uint8 playfield_col_mask;         /* Playfield column mask */
-uint16 playfield_row_mask;        /* Playfield row mask */
-uint16 vscroll;                   /* Latched vertical scroll value */
-uint8 odd_frame;                  /* 1: odd field, 0: even field */
-uint8 im2_flag;                   /* 1= Interlace mode 2 is being used */
-uint8 interlaced;                 /* 1: Interlaced mode 1 or 2 */
-uint8 vdp_pal;                    /* 1: PAL , 0: NTSC (default) */
-uint8 h_counter;                  /* Horizontal counter */
-uint16 v_counter;                 /* Vertical counter */
-uint16 vc_max;                    /* Vertical counter overflow value */
-uint16 lines_per_frame;           /* PAL: 313 lines, NTSC: 262 lines */
-uint16 max_sprite_pixels;         /* Max. sprites pixels per line (parsing & rendering) */
-int32 fifo_write_cnt;             /* VDP FIFO write count */
-uint32 fifo_slots;                /* VDP FIFO access slot count */
-uint32 hvc_latch;                 /* latched HV counter */
-const uint8 *hctab;               /* pointer to H Counter table */
+CONTEXT_LOCAL uint16 ntab;                      /* Name table A base address */
+CONTEXT_LOCAL uint16 ntbb;                      /* Name table B base address */
+CONTEXT_LOCAL uint16 ntwb;                      /* Name table W base address */
+CONTEXT_LOCAL uint16 satb;                      /* Sprite attribute table base address */
+CONTEXT_LOCAL uint16 hscb;                      /* Horizontal scroll table base address */
+CONTEXT_LOCAL uint8 bg_name_dirty[0x800];       /* 1= This pattern is dirty */
+CONTEXT_LOCAL uint16 bg_name_list[0x800];       /* List of modified pattern indices */
+CONTEXT_LOCAL uint16 bg_list_index;             /* # of modified patterns in list */
+CONTEXT_LOCAL uint8 hscroll_mask;               /* Horizontal Scrolling line mask */
+CONTEXT_LOCAL uint8 playfield_shift;            /* Width of planes A, B (in bits) */
+CONTEXT_LOCAL uint8 playfield_col_mask;         /* Playfield column mask */
+CONTEXT_LOCAL uint16 playfield_row_mask;        /* Playfield row mask */
+CONTEXT_LOCAL uint16 vscroll;                   /* Latched vertical scroll value */
+CONTEXT_LOCAL uint8 odd_frame;                  /* 1: odd field, 0: even field */
+CONTEXT_LOCAL uint8 im2_flag;                   /* 1= Interlace mode 2 is being used */
+CONTEXT_LOCAL uint8 interlaced;                 /* 1: Interlaced mode 1 or 2 */
+CONTEXT_LOCAL uint8 vdp_pal;                    /* 1: PAL , 0: NTSC (default) */
+CONTEXT_LOCAL uint8 h_counter;                  /* Horizontal counter */
+CONTEXT_LOCAL uint16 v_counter;                 /* Vertical counter */
+CONTEXT_LOCAL uint16 vc_max;                    /* Vertical counter overflow value */
+CONTEXT_LOCAL uint16 lines_per_frame;           /* PAL: 313 lines, NTSC: 262 lines */
+CONTEXT_LOCAL uint16 max_sprite_pixels;         /* Max. sprites pixels per line (parsing & rendering) */
+CONTEXT_LOCAL int32 fifo_write_cnt;             /* VDP FIFO write count */
+CONTEXT_LOCAL uint32 fifo_slots;                /* VDP FIFO access slot count */
+CONTEXT_LOCAL uint32 hvc_latch;                 /* latched HV counter */
+CONTEXT_LOCAL const uint8 *hctab;               /* pointer to H Counter table */
 
 /* Function pointers */
-void (*vdp_68k_data_w)(unsigned int data);
-void (*vdp_z80_data_w)(unsigned int data);
-unsigned int (*vdp_68k_data_r)(void);
-unsigned int (*vdp_z80_data_r)(void);
+CONTEXT_LOCAL void (*vdp_68k_data_w)(unsigned int data);
+CONTEXT_LOCAL void (*vdp_z80_data_w)(unsigned int data);
+CONTEXT_LOCAL unsigned int (*vdp_68k_data_r)(void);
+CONTEXT_LOCAL unsigned int (*vdp_z80_data_r)(void);
 
 /* Function prototypes */
 static void vdp_68k_data_w_m4(unsigned int data);
@@ -125,27 +146,27 @@ static const uint8 shift_table[]        = { 6, 7, 0, 8 };
 static const uint8 col_mask_table[]     = { 0x0F, 0x1F, 0x0F, 0x3F };
 static const uint16 row_mask_table[]    = { 0x0FF, 0x1FF, 0x2FF, 0x3FF };
 
-static uint8 border;          /* Border color index */
-static uint8 pending;         /* Pending write flag */
-static uint8 code;            /* Code register */
-static uint8 dma_type;        /* DMA mode */
-static uint16 addr;           /* Address register */
-static uint16 addr_latch;     /* Latched A15, A14 of address */
-static uint16 sat_base_mask;  /* Base bits of SAT */
-static uint16 sat_addr_mask;  /* Index bits of SAT */
-static uint16 dma_src;        /* DMA source address */
-static uint32 dma_endCycles;  /* 68k cycles to DMA end */
-static int dmafill;           /* DMA Fill pending flag */
-static int cached_write;      /* 2nd part of 32-bit CTRL port write (Genesis mode) or LSB of CRAM data (Game Gear mode) */
-static uint16 fifo[4];        /* FIFO ring-buffer */
-static int fifo_idx;          /* FIFO write index */
-static int fifo_byte_access;  /* FIFO byte access flag */
-static uint32 fifo_cycles;    /* FIFO next access cycle */
-static int *fifo_timing;      /* FIFO slots timing table */
+static CONTEXT_LOCAL uint8 border;          /* Border color index */
+static CONTEXT_LOCAL uint8 pending;         /* Pending write flag */
+static CONTEXT_LOCAL uint8 code;            /* Code register */
+static CONTEXT_LOCAL uint8 dma_type;        /* DMA mode */
+static CONTEXT_LOCAL uint16 addr;           /* Address register */
+static CONTEXT_LOCAL uint16 addr_latch;     /* Latched A15, A14 of address */
+static CONTEXT_LOCAL uint16 sat_base_mask;  /* Base bits of SAT */
+static CONTEXT_LOCAL uint16 sat_addr_mask;  /* Index bits of SAT */
+static CONTEXT_LOCAL uint16 dma_src;        /* DMA source address */
+static CONTEXT_LOCAL uint32 dma_endCycles;  /* 68k cycles to DMA end */
+static CONTEXT_LOCAL int dmafill;           /* DMA Fill pending flag */
+static CONTEXT_LOCAL int cached_write;      /* 2nd part of 32-bit CTRL port write (Genesis mode) or LSB of CRAM data (Game Gear mode) */
+static CONTEXT_LOCAL uint16 fifo[4];        /* FIFO ring-buffer */
+static CONTEXT_LOCAL int fifo_idx;          /* FIFO write index */
+static CONTEXT_LOCAL int fifo_byte_access;  /* FIFO byte access flag */
+static CONTEXT_LOCAL uint32 fifo_cycles;    /* FIFO next access cycle */
+static CONTEXT_LOCAL int *fifo_timing;      /* FIFO slots timing table */
 
  /* set Z80 or 68k interrupt lines */
-static void (*set_irq_line)(unsigned int level);
-static void (*set_irq_line_delay)(unsigned int level);
+static CONTEXT_LOCAL void (*set_irq_line)(unsigned int level);
+static CONTEXT_LOCAL void (*set_irq_line_delay)(unsigned int level);
 
 /* Vertical counter overflow values (see hvc.h) */
 static const uint16 vc_table[4][2] = 
@@ -245,6 +266,7 @@ void vdp_reset(void)
 
   memset ((char *) sat, 0, sizeof (sat));
   memset ((char *) vram, 0, sizeof (vram));
+  sprite_index_dirty = 1;
   memset ((char *) cram, 0, sizeof (cram));
   memset ((char *) vsram, 0, sizeof (vsram));
   memset ((char *) reg, 0, sizeof (reg));
@@ -441,7 +463,7 @@ int vdp_context_save(uint8 *state)
   int bufferptr = 0;
 
   save_param(sat, sizeof(sat));
-  save_param(vram, sizeof(vram));
+  bufferptr += state_save_pages(&state[bufferptr], STATE_PAGES_VRAM, vram, sizeof(vram));
   save_param(cram, sizeof(cram));
   save_param(vsram, sizeof(vsram));
   save_param(reg, sizeof(reg));
@@ -469,7 +491,8 @@ int vdp_context_load(uint8 *state)
   uint8 temp_reg[0x20];
 
   load_param(sat, sizeof(sat));
-  load_param(vram, sizeof(vram));
+  sprite_index_dirty = 1;
+  bufferptr += state_load_pages(&state[bufferptr], STATE_PAGES_VRAM, vram, sizeof(vram));
   load_param(cram, sizeof(cram));
   load_param(vsram, sizeof(vsram));
   load_param(temp_reg, sizeof(temp_reg));
@@ -575,6 +598,11 @@ void vdp_dma_update(unsigned int cycles)
 {
   unsigned int dma_cycles, dma_bytes;
 
+  /* Render queued lines before VDP memory changes */
+  RENDER_SYNC();
+
+  PROFILER_ENTER(PROFILER_DMA);
+
   /* DMA transfer rate (bytes per line) 
 
       DMA Mode      Width       Display      Transfer Count
@@ -682,6 +710,8 @@ void vdp_dma_update(unsigned int cycles)
       }
     }
   }
+
+  PROFILER_LEAVE();
 }
 
 
@@ -691,6 +721,9 @@ void vdp_dma_update(unsigned int cycles)
 
 void vdp_68k_ctrl_w(unsigned int data)
 {
+  /* Registers may change: render queued lines first */
+  RENDER_SYNC();
+
   /* Check pending flag */
   if (pending == 0)
   {
@@ -839,6 +872,9 @@ void vdp_68k_ctrl_w(unsigned int data)
 /* Mega Drive VDP control port specific (MS compatibility mode) */
 void vdp_z80_ctrl_w(unsigned int data)
 {
+  /* Registers may change: render queued lines first */
+  RENDER_SYNC();
+
   switch (pending)
   {
     case 0:
@@ -1151,6 +1187,9 @@ unsigned int vdp_68k_ctrl_r(unsigned int cycles)
 {
   unsigned int temp;
 
+  /* Sprite overflow & collision flags are set by rendering */
+  RENDER_SYNC();
+
   /* Cycle-accurate VDP status read (adjust CPU time with current instruction execution time) */
   cycles += m68k_cycles();
 
@@ -1214,6 +1253,9 @@ unsigned int vdp_z80_ctrl_r(unsigned int cycles)
 {
   unsigned int temp;
 
+  /* Sprite overflow & collision flags are set by rendering */
+  RENDER_SYNC();
+
   /* Check if DMA busy flag is set (Mega Drive VDP specific) */
   if (status & 2)
   {
@@ -1576,6 +1618,12 @@ static void vdp_reg_w(unsigned int r, unsigned int d, unsigned int cycles)
               *(uint16 *)(vram + ((i & 0x203F) | ((i >> 6) & 0x40) | ((i << 1) & 0x1F80))) = *(uint16 *)(vram + 0x4000 + i);
             }
           }
+
+          /* both copies were rewritten */
+          for (i=0; i<0x8000; i+=STATE_PAGE_SIZE)
+          {
+            STATE_DIRTY_VRAM(i);
+          }
         }
       }
 
@@ -1971,7 +2019,7 @@ static void vdp_reg_w(unsigned int r, unsigned int d, unsigned int cycles)
           window_clip(reg[17], 1);
 
           /* Update max sprite pixels per line*/
-          max_sprite_pixels = 400;
+          max_sprite_pixels = config_legacy.screen_width;
 
           /* FIFO access slots timings */
           fifo_timing = (int *)fifo_timing_h40;
@@ -2152,7 +2200,7 @@ static void vdp_bus_w(unsigned int data)
       if ((index & sat_base_mask) == satb)
       {
         /* Update internal SAT */
-        *(uint16 *) &sat[index & sat_addr_mask] = data;
+        WRITE_SAT_WORD(index & sat_addr_mask, data);
       }
 
       /* Only write unique data to VRAM */
@@ -2275,6 +2323,9 @@ static void vdp_bus_w(unsigned int data)
 
 static void vdp_68k_data_w_m4(unsigned int data)
 {
+  /* VRAM, CRAM or VSRAM may change: render queued lines first */
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2367,6 +2418,9 @@ static void vdp_68k_data_w_m4(unsigned int data)
 
 static void vdp_68k_data_w_m5(unsigned int data)
 {
+  /* VRAM, CRAM or VSRAM may change: render queued lines first */
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2556,6 +2610,9 @@ static unsigned int vdp_68k_data_r_m5(void)
 
 static void vdp_z80_data_w_m4(unsigned int data)
 {
+  /* VRAM, CRAM or VSRAM may change: render queued lines first */
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2608,6 +2665,9 @@ static void vdp_z80_data_w_m4(unsigned int data)
 
 static void vdp_z80_data_w_m5(unsigned int data)
 {
+  /* VRAM, CRAM or VSRAM may change: render queued lines first */
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2627,7 +2687,7 @@ static void vdp_z80_data_w_m5(unsigned int data)
       if ((index & sat_base_mask) == satb)
       {
         /* Update internal SAT */
-        WRITE_BYTE(sat, index & sat_addr_mask, data);
+        WRITE_SAT_BYTE(index & sat_addr_mask, data);
       }
 
       /* Only write unique data to VRAM */
@@ -2962,6 +3022,7 @@ static void vdp_z80_data_w_sg(unsigned int data)
 
   /* VRAM write */
   vram[index] = data;
+  STATE_DIRTY_VRAM(index);
 
   /* Update address register */
   addr++;
@@ -3107,7 +3168,7 @@ static void vdp_dma_copy(unsigned int length)
       if ((addr & sat_base_mask) == satb)
       {
         /* Update internal SAT */
-        WRITE_BYTE(sat, (addr & sat_addr_mask) ^ 1, data);
+        WRITE_SAT_BYTE((addr & sat_addr_mask) ^ 1, data);
       }
 
       /* Write byte to adjacent VRAM destination address */
@@ -3148,7 +3209,7 @@ static void vdp_dma_fill(unsigned int length)
         if ((addr & sat_base_mask) == satb)
         {
           /* Update internal SAT */
-          WRITE_BYTE(sat, (addr & sat_addr_mask) ^ 1, data);
+          WRITE_SAT_BYTE((addr & sat_addr_mask) ^ 1, data);
         }
 
         /* Write byte to adjacent VRAM address */
@@ -3233,3 +3294,67 @@ static void vdp_dma_fill(unsigned int length)
     }
   }
 }
+
+#ifdef USE_CORE_CONTEXT
+void vdp_ctrl_context_regions(void)
+{
+  CONTEXT_REGION(sat);
+  CONTEXT_REGION(vram);
+  CONTEXT_REGION(cram);
+  CONTEXT_REGION(vsram);
+  CONTEXT_REGION(reg);
+  CONTEXT_REGION(hint_pending);
+  CONTEXT_REGION(vint_pending);
+  CONTEXT_REGION(status);
+  CONTEXT_REGION(dma_length);
+  CONTEXT_REGION(ntab);
+  CONTEXT_REGION(ntbb);
+  CONTEXT_REGION(ntwb);
+  CONTEXT_REGION(satb);
+  CONTEXT_REGION(hscb);
+  CONTEXT_REGION(bg_name_dirty);
+  CONTEXT_REGION(bg_name_list);
+  CONTEXT_REGION(bg_list_index);
+  CONTEXT_REGION(hscroll_mask);
+  CONTEXT_REGION(playfield_shift);
+  CONTEXT_REGION(playfield_col_mask);
+  CONTEXT_REGION(playfield_row_mask);
+  CONTEXT_REGION(vscroll);
+  CONTEXT_REGION(odd_frame);
+  CONTEXT_REGION(im2_flag);
+  CONTEXT_REGION(interlaced);
+  CONTEXT_REGION(vdp_pal);
+  CONTEXT_REGION(h_counter);
+  CONTEXT_REGION(v_counter);
+  CONTEXT_REGION(vc_max);
+  CONTEXT_REGION(lines_per_frame);
+  CONTEXT_REGION(max_sprite_pixels);
+  CONTEXT_REGION(fifo_write_cnt);
+  CONTEXT_REGION(fifo_slots);
+  CONTEXT_REGION(hvc_latch);
+  CONTEXT_REGION(hctab);
+  CONTEXT_REGION(vdp_68k_data_w);
+  CONTEXT_REGION(vdp_z80_data_w);
+  CONTEXT_REGION(vdp_68k_data_r);
+  CONTEXT_REGION(vdp_z80_data_r);
+  CONTEXT_REGION(border);
+  CONTEXT_REGION(pending);
+  CONTEXT_REGION(code);
+  CONTEXT_REGION(dma_type);
+  CONTEXT_REGION(addr);
+  CONTEXT_REGION(addr_latch);
+  CONTEXT_REGION(sat_base_mask);
+  CONTEXT_REGION(sat_addr_mask);
+  CONTEXT_REGION(dma_src);
+  CONTEXT_REGION(dma_endCycles);
+  CONTEXT_REGION(dmafill);
+  CONTEXT_REGION(cached_write);
+  CONTEXT_REGION(fifo);
+  CONTEXT_REGION(fifo_idx);
+  CONTEXT_REGION(fifo_byte_access);
+  CONTEXT_REGION(fifo_cycles);
+  CONTEXT_REGION(fifo_timing);
+  CONTEXT_REGION(set_irq_line);
+  CONTEXT_REGION(set_irq_line_delay);
+}
+#endif
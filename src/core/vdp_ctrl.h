@@ -43,49 +43,49 @@
 #define _VDP_H_
 
 /* VDP context */
-extern uint8 reg[0x20];
-extern uint8 sat[0x400];
-extern uint8 vram[0x10000];
-extern uint8 cram[0x80];
-extern uint8 vsram[0x80];
-extern uint8 hint_pending;
-extern uint8 vint_pending;
-extern uint16 status;
-extern uint32 dma_length;
+extern CONTEXT_LOCAL uint8 reg[0x20];
+extern CONTEXT_LOCAL uint8 sat[0x400];
+extern CONTEXT_LOCAL uint8 vram[0x10000];
+extern CONTEXT_LOCAL uint8 cram[0x80];
+extern CONTEXT_LOCAL uint8 vsram[0x80];
+extern CONTEXT_LOCAL uint8 hint_pending;
+extern CONTEXT_LOCAL uint8 vint_pending;
+extern CONTEXT_LOCAL uint16 status;
+extern CONTEXT_LOCAL uint32 dma_length;
 
 /* Global variables */
-extern uint16 ntab;
-extern uint16 ntbb;
-extern uint16 ntwb;
-extern uint16 satb;
-extern uint16 hscb;
-extern uint8 bg_name_dirty[0x800];
-extern uint16 bg_name_list[0x800];
-extern uint16 bg_list_index;
-extern uint8 hscroll_mask;
-extern uint8 playfield_shift;
-extern uint8 playfield_col_mask;
-extern uint16 playfield_row_mask;
-extern uint8 odd_frame;
-extern uint8 im2_flag;
-extern uint8 interlaced;
-extern uint8 vdp_pal;
-extern uint8 h_counter;
-extern uint16 v_counter;
-extern uint16 vc_max;
-extern uint16 vscroll;
-extern uint16 lines_per_frame;
-extern uint16 max_sprite_pixels;
-extern int32 fifo_write_cnt;
-extern uint32 fifo_slots;
-extern uint32 hvc_latch;
-extern const uint8 *hctab;
+extern CONTEXT_LOCAL uint16 ntab;
+extern CONTEXT_LOCAL uint16 ntbb;
+extern CONTEXT_LOCAL uint16 ntwb;
+extern CONTEXT_LOCAL uint16 satb;
+extern CONTEXT_LOCAL uint16 hscb;
+extern CONTEXT_LOCAL uint8 bg_name_dirty[0x800];
+extern CONTEXT_LOCAL uint16 bg_name_list[0x800];
+extern CONTEXT_LOCAL uint16 bg_list_index;
+extern CONTEXT_LOCAL uint8 hscroll_mask;
+extern CONTEXT_LOCAL uint8 playfield_shift;
+extern CONTEXT_LOCAL uint8 playfield_col_mask;
+extern CONTEXT_LOCAL uint16 playfield_row_mask;
+extern CONTEXT_LOCAL uint8 odd_frame;
+extern CONTEXT_LOCAL uint8 im2_flag;
+extern CONTEXT_LOCAL uint8 interlaced;
+extern CONTEXT_LOCAL uint8 vdp_pal;
+extern CONTEXT_LOCAL uint8 h_counter;
+extern CONTEXT_LOCAL uint16 v_counter;
+extern CONTEXT_LOCAL uint16 vc_max;
+extern CONTEXT_LOCAL uint16 vscroll;
+extern CONTEXT_LOCAL uint16 lines_per_frame;
+extern CONTEXT_LOCAL uint16 max_sprite_pixels;
+extern CONTEXT_LOCAL int32 fifo_write_cnt;
+extern CONTEXT_LOCAL uint32 fifo_slots;
+extern CONTEXT_LOCAL uint32 hvc_latch;
+extern CONTEXT_LOCAL const uint8 *hctab;
 
 /* Function pointers */
-extern void (*vdp_68k_data_w)(unsigned int data);
-extern void (*vdp_z80_data_w)(unsigned int data);
-extern unsigned int (*vdp_68k_data_r)(void);
-extern unsigned int (*vdp_z80_data_r)(void);
+extern CONTEXT_LOCAL void (*vdp_68k_data_w)(unsigned int data);
+extern CONTEXT_LOCAL void (*vdp_z80_data_w)(unsigned int data);
+extern CONTEXT_LOCAL unsigned int (*vdp_68k_data_r)(void);
+extern CONTEXT_LOCAL unsigned int (*vdp_z80_data_r)(void);
 
 /* Function prototypes */
 extern void vdp_init(void);
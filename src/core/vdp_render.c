@@ -43,6 +43,72 @@
 #include "md_ntsc.h"
 #include "sms_ntsc.h"
 
+/* Vector versions of the hot loops (pattern cache, layer merging) when the target has them */
+#if defined(LSB_FIRST) && defined(__SSE2__)
+#include <emmintrin.h>
+#define RENDER_SSE2
+#elif defined(LSB_FIRST) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RENDER_NEON
+#endif
+
+/* 32-bit palette remap with AVX2 gathers, used when the CPU supports them */
+#if defined(USE_32BPP_RENDERING) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define REMAP_AVX2
+#endif
+
+#ifdef USE_PARALLEL_RENDER
+#include "renderpool.h"
+
+#ifndef USE_DEFERRED_RENDER
+#error "USE_PARALLEL_RENDER requires USE_DEFERRED_RENDER"
+#endif
+#ifdef USE_CORE_CONTEXT
+#error "USE_PARALLEL_RENDER can't be used with USE_CORE_CONTEXT"
+#endif
+#ifdef USE_LAZY_PATTERN_FLIP
+#error "USE_PARALLEL_RENDER can't be used with USE_LAZY_PATTERN_FLIP"
+#endif
+
+/* Line buffers & sprite state are private to each render thread */
+#if defined(_MSC_VER)
+#define RENDER_LOCAL __declspec(thread)
+#else
+#define RENDER_LOCAL __thread
+#endif
+
+/* Mode 5 sprite flags go through a pointer, so render threads can keep theirs apart */
+#define SPRITE_STATUS (*spr_status)
+
+#ifdef ENABLE_PROFILER
+/* Profiler sections are entered from the emulation thread only */
+static RENDER_LOCAL int render_worker;
+#define RENDER_PROFILER_ENTER() if (!render_worker) PROFILER_ENTER(PROFILER_RENDER)
+#define RENDER_PROFILER_LEAVE() if (!render_worker) PROFILER_LEAVE()
+#endif
+#else
+#define RENDER_LOCAL CONTEXT_LOCAL
+#define SPRITE_STATUS status
+#endif
+
+#ifndef RENDER_PROFILER_ENTER
+#define RENDER_PROFILER_ENTER() PROFILER_ENTER(PROFILER_RENDER)
+#define RENDER_PROFILER_LEAVE() PROFILER_LEAVE()
+#endif
+
+#ifdef USE_GPU_RENDER
+#ifdef USE_PARALLEL_RENDER
+#error "USE_GPU_RENDER can't be used with USE_PARALLEL_RENDER"
+#endif
+#ifdef USE_CORE_CONTEXT
+#error "USE_GPU_RENDER can't be used with USE_CORE_CONTEXT"
+#endif
+#ifndef USE_32BPP_RENDERING
+#error "USE_GPU_RENDER requires USE_32BPP_RENDERING"
+#endif
+#endif
+
 #ifdef HAVE_NO_SPRITE_LIMIT
 #define MAX_SPRITES_PER_LINE 80
 #define TMS_MAX_SPRITES_PER_LINE (config_legacy.no_sprite_limit ? MAX_SPRITES_PER_LINE : 4)
@@ -50,7 +116,7 @@
 #define MODE5_MAX_SPRITES_PER_LINE (config_legacy.no_sprite_limit ? MAX_SPRITES_PER_LINE : (bitmap.viewport.w >> 4))
 #define MODE5_MAX_SPRITE_PIXELS (config_legacy.no_sprite_limit ? MAX_SPRITES_PER_LINE * 32 : max_sprite_pixels)
 #else
-#define MAX_SPRITES_PER_LINE 20
+#define MAX_SPRITES_PER_LINE (SCREEN_WIDTH_MAX >> 4)
 #define TMS_MAX_SPRITES_PER_LINE 4
 #define MODE4_MAX_SPRITES_PER_LINE 8
 #define MODE5_MAX_SPRITES_PER_LINE (bitmap.viewport.w >> 4)
@@ -135,10 +201,10 @@ INLINE void WRITE_LONG(void *address, uint32 data)
 */
 #define GET_LSB_TILE(ATTR, LINE) \
   atex = atex_table[(ATTR >> 13) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[(ATTR & 0x00001FFF) << 6 | (LINE)];
+  src = (uint32 *)BG_PATTERN_M5((ATTR & 0x00001FFF) << 6 | (LINE));
 #define GET_MSB_TILE(ATTR, LINE) \
   atex = atex_table[(ATTR >> 29) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[(ATTR & 0x1FFF0000) >> 10 | (LINE)];
+  src = (uint32 *)BG_PATTERN_M5((ATTR & 0x1FFF0000) >> 10 | (LINE));
 
 /* Draw 2-cell column (16 pixels high) */
 /*
@@ -152,10 +218,10 @@ INLINE void WRITE_LONG(void *address, uint32 data)
 */
 #define GET_LSB_TILE_IM2(ATTR, LINE) \
   atex = atex_table[(ATTR >> 13) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[((ATTR & 0x000003FF) << 7 | (ATTR & 0x00001800) << 6 | (LINE)) ^ ((ATTR & 0x00001000) >> 6)];
+  src = (uint32 *)BG_PATTERN_M5(((ATTR & 0x000003FF) << 7 | (ATTR & 0x00001800) << 6 | (LINE)) ^ ((ATTR & 0x00001000) >> 6));
 #define GET_MSB_TILE_IM2(ATTR, LINE) \
   atex = atex_table[(ATTR >> 29) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[((ATTR & 0x03FF0000) >> 9 | (ATTR & 0x18000000) >> 10 | (LINE)) ^ ((ATTR & 0x10000000) >> 22)];
+  src = (uint32 *)BG_PATTERN_M5(((ATTR & 0x03FF0000) >> 9 | (ATTR & 0x18000000) >> 10 | (LINE)) ^ ((ATTR & 0x10000000) >> 22));
 
 /*
    One column = 2 tiles
@@ -423,7 +489,7 @@ INLINE void WRITE_LONG(void *address, uint32 data)
 #endif /* ALIGN_LONG */
 #endif /* ALT_RENDERER */
 
-#define DRAW_SPRITE_TILE(WIDTH,ATTR,TABLE)  \
+#define DRAW_SPRITE_TILE(WIDTH,ATTR,TABLE,STATUS)  \
   for (i=0;i<WIDTH;i++) \
   { \
     temp = *src++; \
@@ -431,7 +497,7 @@ INLINE void WRITE_LONG(void *address, uint32 data)
     { \
       temp |= (lb[i] << 8); \
       lb[i] = TABLE[temp | ATTR]; \
-      status |= ((temp & 0x8000) >> 10); \
+      STATUS |= ((temp & 0x8000) >> 10); \
     } \
   }
 
@@ -495,11 +561,15 @@ INLINE void WRITE_LONG(void *address, uint32 data)
 
 /* 8:8:8 RGB */
 #elif defined(USE_32BPP_RENDERING)
+#if defined(USE_ABGR)
+#define MAKE_PIXEL(r,g,b) ((0xff << 24) | (b) << 20 | (b) << 16 | (g) << 12 | (g)  << 8 | (r) << 4 | (r))
+#else
 #define MAKE_PIXEL(r,g,b) ((0xff << 24) | (r) << 20 | (r) << 16 | (g) << 12 | (g)  << 8 | (b) << 4 | (b))
 #endif
+#endif
 
 /* Window & Plane A clipping */
-static struct clip_t
+static CONTEXT_LOCAL struct clip_t
 {
   uint8 left;
   uint8 right;
@@ -556,6 +626,15 @@ static const uint16 tms_palette[16] =
   0x2567, 0xC2F7, 0xCE59, 0xFFFF
 };
 
+#elif defined(USE_32BPP_RENDERING) && defined(USE_ABGR)
+static const uint32 tms_palette[16] =
+{
+  0xFF000000, 0xFF000000, 0xFF42C821, 0xFF78DC5E,
+  0xFFED5554, 0xFFFC767D, 0xFF4D52D4, 0xFFF5EB42,
+  0xFF5455FC, 0xFF7879FF, 0xFF54C1D4, 0xFF80CEE6,
+  0xFF3BB021, 0xFFB45BC9, 0xFFCCCCCC, 0xFFFFFFFF
+};
+
 #elif defined(USE_32BPP_RENDERING)
 static const uint32 tms_palette[16] =
 {
@@ -567,7 +646,13 @@ static const uint32 tms_palette[16] =
 #endif
 
 /* Cached and flipped patterns */
-static uint8 ALIGNED_(4) bg_pattern_cache[0x80000];
+static CONTEXT_LOCAL uint8 ALIGNED_(4) bg_pattern_cache[0x80000];
+
+#ifdef USE_LAZY_PATTERN_FLIP
+/* Mode 5 cached versions that are up to date, one bit per flip combination */
+/* (bit 0 = unflipped, always valid once the pattern has been decoded) */
+static CONTEXT_LOCAL uint8 bg_pattern_flip[0x800];
+#endif
 
 /* Sprite pattern name offset look-up table (Mode 5) */
 static uint8 name_lut[0x400];
@@ -579,17 +664,67 @@ static uint32 bp_lut[0x10000];
 static uint8 lut[LUT_MAX][LUT_SIZE];
 
 /* Output pixel data look-up tables*/
-static PIXEL_OUT_T pixel[0x100];
+static CONTEXT_LOCAL PIXEL_OUT_T pixel[0x100];
 static PIXEL_OUT_T pixel_lut[3][0x200];
 static PIXEL_OUT_T pixel_lut_m4[0x40];
 
+#ifdef USE_GPU_RENDER
+/* Captured lines & palette snapshots (see vdp_render.h) */
+int render_gpu;
+t_gpu_frame gpu_frame;
+
+/* Palette modified since its last snapshot */
+static int gpu_palette_dirty = 1;
+
+/* Pattern snapshot of the frame (0: not taken yet, 1: taken, -1: VRAM */
+/* written since then, remaining lines are drawn by the CPU)            */
+static int gpu_patterns;
+
+/* Opaque sprite pixels of the current line (0x80), for sprite collision */
+static uint8 gpu_sprite_mask[0x20 + SCREEN_WIDTH_MAX + 0x20];
+
+#define PIXEL_TOUCH() gpu_palette_dirty = 1
+#else
+#define PIXEL_TOUCH()
+#endif
+
+#ifdef USE_DIRTY_LINES
+/* Palette content, folded in entry by entry as it is modified (0 = cleared) */
+static CONTEXT_LOCAL uint64_t pixel_key;
+
+INLINE uint64_t pixel_mix(int index, PIXEL_OUT_T data)
+{
+  uint64_t x = (((uint64_t)data << 8) | index) * 0x9E3779B97F4A7C15ULL;
+  return x ^ (x >> 32);
+}
+
+#define PIXEL_SET(index, data) \
+{ \
+  PIXEL_OUT_T pixel_new = (data); \
+  pixel_key ^= pixel_mix((index), pixel[index]) ^ pixel_mix((index), pixel_new); \
+  pixel[index] = pixel_new; \
+  PIXEL_TOUCH(); \
+}
+
+/* Key of what was last converted into each framebuffer line (0 = unknown) */
+static CONTEXT_LOCAL uint64_t line_key[DIRTY_LINES_MAX];
+
+/* Framebuffer these keys belong to */
+static CONTEXT_LOCAL uint8 *line_target;
+
+/* Framebuffer lines rewritten since render_dirty_runs last collected them */
+CONTEXT_LOCAL uint8 render_dirty[DIRTY_LINES_MAX];
+#else
+#define PIXEL_SET(index, data) { pixel[index] = (data); PIXEL_TOUCH(); }
+#endif
+
 /* Background & Sprite line buffers */
-static uint8 linebuf[2][0x200];
+static RENDER_LOCAL uint8 linebuf[2][0x20 + SCREEN_WIDTH_MAX + 0x20];
 
 /* Sprite limit flag */
-static uint8 spr_ovr;
+static RENDER_LOCAL uint8 spr_ovr;
 
-int render_bg_disable = 0;
+CONTEXT_LOCAL int render_bg_disable = 0;
 
 /* Sprite parsing lists */
 typedef struct
@@ -600,19 +735,115 @@ typedef struct
   uint16 size;
 } object_info_t;
 
-static object_info_t obj_info[2][MAX_SPRITES_PER_LINE];
+static RENDER_LOCAL object_info_t obj_info[2][MAX_SPRITES_PER_LINE];
 
 /* Sprite Counter */
-static uint8 object_count[2];
+static RENDER_LOCAL uint8 object_count[2];
+
+/* Mode 5 sprite line index: sprites of the SAT link list, in link order, */
+/* bucketed by the lines they cover (line + 0x81, as compared with Y)     */
+#define SPRITE_INDEX_LINES (0x200 + 32)
+#define SPRITE_INDEX_SIZE  (128 * 32)
+
+static CONTEXT_LOCAL uint16 sprite_index_start[SPRITE_INDEX_LINES + 1];
+static CONTEXT_LOCAL uint8 sprite_index[SPRITE_INDEX_SIZE];
+
+/* Parsing parameters the index was built with */
+static CONTEXT_LOCAL int sprite_index_key;
+
+/* Set when Y position, size or link data of the internal SAT changed */
+CONTEXT_LOCAL uint8 sprite_index_dirty = 1;
 
 /* Sprite Collision Info */
-uint16 spr_col;
+CONTEXT_LOCAL uint16 spr_col;
 
 /* Function pointers */
-void (*render_bg)(int line);
-void (*render_obj)(int line);
-void (*parse_satb)(int line);
-void (*update_bg_pattern_cache)(int index);
+CONTEXT_LOCAL void (*render_bg)(int line);
+CONTEXT_LOCAL void (*render_obj)(int line);
+CONTEXT_LOCAL void (*parse_satb)(int line);
+CONTEXT_LOCAL void (*update_bg_pattern_cache)(int index);
+
+#ifdef USE_DEFERRED_RENDER
+/* Lines waiting to be rendered (interlaced frames render each line twice) */
+#define RENDER_QUEUE_SIZE 512
+
+typedef struct
+{
+  int16 line;
+  uint16 v_counter;
+  uint8 odd_frame;
+  uint8 satb;       /* sprite parsing only */
+} render_queue_t;
+
+static CONTEXT_LOCAL render_queue_t render_queue[RENDER_QUEUE_SIZE];
+CONTEXT_LOCAL int render_pending;
+#endif
+
+#ifdef USE_PARALLEL_RENDER
+/* Mode 5 sprite flags of the current thread (render threads point it to their band) */
+static RENDER_LOCAL uint16 *spr_status = &status;
+
+/* Queued lines are only split when each band gets at least that many */
+#define RENDER_BAND_LINES 16
+#define RENDER_MAX_BANDS  16
+
+typedef struct
+{
+  int first;                /* first & last queue entries */
+  int last;
+  uint16 status;            /* sprite flags raised by the band */
+  uint8 *linebuf;           /* state left by the thread that rendered it */
+  object_info_t *obj_info;
+  uint8 *object_count;
+} render_band_t;
+
+static render_band_t render_band[RENDER_MAX_BANDS];
+#endif
+
+
+/*--------------------------------------------------------------------------*/
+/* Pattern cache access (Mode 5)                                            */
+/*--------------------------------------------------------------------------*/
+
+#ifdef USE_LAZY_PATTERN_FLIP
+/* Build one flipped version of a pattern from its unflipped version */
+static void update_bg_pattern_flip_m5(int name, int flip)
+{
+  int x, y;
+  uint8 *src = &bg_pattern_cache[name << 6];
+  uint8 *dst = &bg_pattern_cache[(flip << 17) | (name << 6)];
+  int vf = (flip & 2) ? 7 : 0;
+  int hf = (flip & 1) ? 7 : 0;
+
+  for (y = 0; y < 8; y++)
+  {
+    for (x = 0; x < 8; x++)
+    {
+      dst[(y << 3) | x] = src[((y ^ vf) << 3) | (x ^ hf)];
+    }
+  }
+
+  bg_pattern_flip[name] |= (1 << flip);
+}
+
+/* Cache address: VH NNNNNNNN NNNYYYxxx (see GET_LSB_TILE) */
+INLINE uint8 *get_bg_pattern_m5(unsigned int index)
+{
+  int name = (index >> 6) & 0x7FF;
+  int flip = index >> 17;
+
+  if (!(bg_pattern_flip[name] & (1 << flip)))
+  {
+    update_bg_pattern_flip_m5(name, flip);
+  }
+
+  return &bg_pattern_cache[index];
+}
+
+#define BG_PATTERN_M5(INDEX) get_bg_pattern_m5(INDEX)
+#else
+#define BG_PATTERN_M5(INDEX) &bg_pattern_cache[INDEX]
+#endif
 
 
 /*--------------------------------------------------------------------------*/
@@ -959,8 +1190,302 @@ static uint32 make_lut_bgobj_m4(uint32 bx, uint32 sx)
 /* Pixel layer merging function                                             */
 /*--------------------------------------------------------------------------*/
 
+#if defined(RENDER_SSE2)
+
+/* Same results as lut[0] (make_lut_bg) or lut[2] (make_lut_bg_ste), 16 pixels at a time */
+static int merge_bg_simd(uint8 *srca, uint8 *srcb, uint8 *dst, int ste, int width)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i m0f = _mm_set1_epi8(0x0F);
+  const __m128i m40 = _mm_set1_epi8(0x40);
+  const __m128i m7f = _mm_set1_epi8(0x7F);
+  const __m128i intensity = ste ? _mm_set1_epi8((char)0x80) : zero;
+  int i;
+
+  for (i = 0; (i + 16) <= width; i += 16)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)&srca[i]);
+    __m128i b = _mm_loadu_si128((const __m128i *)&srcb[i]);
+    __m128i at = _mm_cmpeq_epi8(_mm_and_si128(a, m0f), zero);
+    __m128i bt = _mm_cmpeq_epi8(_mm_and_si128(b, m0f), zero);
+    __m128i ap = _mm_cmpeq_epi8(_mm_and_si128(a, m40), m40);
+    __m128i bp = _mm_cmpeq_epi8(_mm_and_si128(b, m40), m40);
+
+    /* B wins when it is the only high priority pixel and is opaque, or when A is transparent */
+    __m128i bonly = _mm_andnot_si128(ap, bp);
+    __m128i selb = _mm_or_si128(_mm_andnot_si128(bt, bonly), _mm_andnot_si128(bonly, at));
+    __m128i c = _mm_and_si128(_mm_or_si128(_mm_and_si128(selb, b), _mm_andnot_si128(selb, a)), m7f);
+
+    /* Normal intensity when either pixel has high priority */
+    c = _mm_or_si128(c, _mm_and_si128(_mm_or_si128(ap, bp), intensity));
+
+    /* Strip palette & priority bits from transparent pixels */
+    c = _mm_andnot_si128(_mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(c, m0f), zero), m7f), c);
+
+    _mm_storeu_si128((__m128i *)&dst[i], c);
+  }
+
+  return i;
+}
+
+/* Same results as lut[4] (make_lut_bgobj_ste), 16 pixels at a time */
+static int merge_bgobj_ste_simd(uint8 *srca, uint8 *srcb, uint8 *dst, int width)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i m0e = _mm_set1_epi8(0x0E);
+  const __m128i m0f = _mm_set1_epi8(0x0F);
+  const __m128i m3e = _mm_set1_epi8(0x3E);
+  const __m128i m3f = _mm_set1_epi8(0x3F);
+  const __m128i m40 = _mm_set1_epi8(0x40);
+  const __m128i m7f = _mm_set1_epi8(0x7F);
+  const __m128i m80 = _mm_set1_epi8((char)0x80);
+  int i;
+
+  for (i = 0; (i + 16) <= width; i += 16)
+  {
+    __m128i s = _mm_loadu_si128((const __m128i *)&srca[i]);
+    __m128i b = _mm_loadu_si128((const __m128i *)&srcb[i]);
+    __m128i st = _mm_cmpeq_epi8(_mm_and_si128(s, m0f), zero);
+    __m128i sp = _mm_cmpeq_epi8(_mm_and_si128(s, m40), m40);
+    __m128i bt = _mm_cmpeq_epi8(_mm_and_si128(b, m0f), zero);
+    __m128i bp = _mm_cmpeq_epi8(_mm_and_si128(b, m40), m40);
+    __m128i bn = _mm_cmplt_epi8(b, zero);
+    __m128i bf = _mm_and_si128(b, m3f);
+    __m128i bi = _mm_and_si128(bn, m40);
+    __m128i sf = _mm_and_si128(s, m3f);
+
+    /* Palette 3 color 15 (shadow) or 14 (highlight) operators */
+    __m128i shadow = _mm_cmpeq_epi8(sf, m3f);
+    __m128i op = _mm_or_si128(shadow, _mm_cmpeq_epi8(sf, m3e));
+    __m128i opc = _mm_or_si128(bf, _mm_andnot_si128(shadow, _mm_or_si128(_mm_and_si128(bn, m80), _mm_andnot_si128(bn, m40))));
+
+    /* Color 14 of other palettes is always normal intensity */
+    __m128i c14 = _mm_cmpeq_epi8(_mm_and_si128(s, m0f), m0e);
+    __m128i spr = _mm_or_si128(_mm_and_si128(c14, _mm_or_si128(sf, m40)), _mm_andnot_si128(c14, _mm_or_si128(_mm_and_si128(s, m7f), bi)));
+    __m128i c;
+
+    spr = _mm_or_si128(_mm_and_si128(op, opc), _mm_andnot_si128(op, spr));
+
+    /* Background shows where the sprite is transparent or behind an opaque high priority pixel */
+    c = _mm_or_si128(st, _mm_andnot_si128(sp, _mm_andnot_si128(bt, bp)));
+    c = _mm_or_si128(_mm_and_si128(c, _mm_or_si128(bf, bi)), _mm_andnot_si128(c, spr));
+
+    /* Strip palette bits from transparent pixels */
+    c = _mm_andnot_si128(_mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(c, m0f), zero), m3f), c);
+
+    _mm_storeu_si128((__m128i *)&dst[i], c);
+  }
+
+  return i;
+}
+
+/* Same results as DRAW_SPRITE_TILE(8,atex,lut[1]), returns the sprite collision flag */
+INLINE int draw_sprite_tile_m5(uint8 *lb, uint8 *src, int atex)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i m0f = _mm_set1_epi8(0x0F);
+  const __m128i m3f = _mm_set1_epi8(0x3F);
+  __m128i s = _mm_loadl_epi64((const __m128i *)src);
+  __m128i b = _mm_loadl_epi64((const __m128i *)lb);
+  __m128i st = _mm_cmpeq_epi8(_mm_and_si128(s, m0f), zero);
+  __m128i bs = _mm_cmplt_epi8(b, zero);
+  __m128i c = _mm_and_si128(_mm_or_si128(s, _mm_set1_epi8(atex)), m3f);
+
+  /* Low priority sprite is behind opaque high priority background pixels */
+  if (!(atex & 0x40))
+  {
+    const __m128i m40 = _mm_set1_epi8(0x40);
+    __m128i bg = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_and_si128(b, m0f), zero), _mm_cmpeq_epi8(_mm_and_si128(b, m40), m40));
+    c = _mm_or_si128(_mm_and_si128(bg, _mm_and_si128(b, m3f)), _mm_andnot_si128(bg, c));
+  }
+
+  /* Pixels already covered by a sprite are left untouched */
+  c = _mm_or_si128(c, _mm_set1_epi8((char)0x80));
+  bs = _mm_or_si128(bs, st);
+  _mm_storel_epi64((__m128i *)lb, _mm_or_si128(_mm_and_si128(bs, b), _mm_andnot_si128(bs, c)));
+
+  return (_mm_movemask_epi8(_mm_andnot_si128(st, _mm_cmplt_epi8(b, zero))) & 0xFF) ? 0x20 : 0x00;
+}
+
+#elif defined(RENDER_NEON)
+
+/* Same results as lut[0] (make_lut_bg) or lut[2] (make_lut_bg_ste), 16 pixels at a time */
+static int merge_bg_simd(uint8 *srca, uint8 *srcb, uint8 *dst, int ste, int width)
+{
+  const uint8x16_t m0f = vdupq_n_u8(0x0F);
+  const uint8x16_t m40 = vdupq_n_u8(0x40);
+  const uint8x16_t m7f = vdupq_n_u8(0x7F);
+  const uint8x16_t intensity = vdupq_n_u8(ste ? 0x80 : 0x00);
+  int i;
+
+  for (i = 0; (i + 16) <= width; i += 16)
+  {
+    uint8x16_t a = vld1q_u8(&srca[i]);
+    uint8x16_t b = vld1q_u8(&srcb[i]);
+    uint8x16_t ao = vtstq_u8(a, m0f);
+    uint8x16_t bo = vtstq_u8(b, m0f);
+    uint8x16_t ap = vtstq_u8(a, m40);
+    uint8x16_t bp = vtstq_u8(b, m40);
+
+    /* B wins when it is the only high priority pixel and is opaque, or when A is transparent */
+    uint8x16_t selb = vbslq_u8(vbicq_u8(bp, ap), bo, vmvnq_u8(ao));
+    uint8x16_t c = vandq_u8(vbslq_u8(selb, b, a), m7f);
+
+    /* Normal intensity when either pixel has high priority */
+    c = vorrq_u8(c, vandq_u8(vorrq_u8(ap, bp), intensity));
+
+    /* Strip palette & priority bits from transparent pixels */
+    c = vbicq_u8(c, vbicq_u8(m7f, vtstq_u8(c, m0f)));
+
+    vst1q_u8(&dst[i], c);
+  }
+
+  return i;
+}
+
+/* Same results as lut[4] (make_lut_bgobj_ste), 16 pixels at a time */
+static int merge_bgobj_ste_simd(uint8 *srca, uint8 *srcb, uint8 *dst, int width)
+{
+  const uint8x16_t m0e = vdupq_n_u8(0x0E);
+  const uint8x16_t m0f = vdupq_n_u8(0x0F);
+  const uint8x16_t m3e = vdupq_n_u8(0x3E);
+  const uint8x16_t m3f = vdupq_n_u8(0x3F);
+  const uint8x16_t m40 = vdupq_n_u8(0x40);
+  const uint8x16_t m7f = vdupq_n_u8(0x7F);
+  const uint8x16_t m80 = vdupq_n_u8(0x80);
+  int i;
+
+  for (i = 0; (i + 16) <= width; i += 16)
+  {
+    uint8x16_t s = vld1q_u8(&srca[i]);
+    uint8x16_t b = vld1q_u8(&srcb[i]);
+    uint8x16_t so = vtstq_u8(s, m0f);
+    uint8x16_t sp = vtstq_u8(s, m40);
+    uint8x16_t bo = vtstq_u8(b, m0f);
+    uint8x16_t bp = vtstq_u8(b, m40);
+    uint8x16_t bn = vtstq_u8(b, m80);
+    uint8x16_t bf = vandq_u8(b, m3f);
+    uint8x16_t bi = vandq_u8(bn, m40);
+    uint8x16_t sf = vandq_u8(s, m3f);
+
+    /* Palette 3 color 15 (shadow) or 14 (highlight) operators */
+    uint8x16_t shadow = vceqq_u8(sf, m3f);
+    uint8x16_t op = vorrq_u8(shadow, vceqq_u8(sf, m3e));
+    uint8x16_t opc = vorrq_u8(bf, vbicq_u8(vbslq_u8(bn, m80, m40), shadow));
+
+    /* Color 14 of other palettes is always normal intensity */
+    uint8x16_t c14 = vceqq_u8(vandq_u8(s, m0f), m0e);
+    uint8x16_t spr = vbslq_u8(c14, vorrq_u8(sf, m40), vorrq_u8(vandq_u8(s, m7f), bi));
+    uint8x16_t c;
+
+    spr = vbslq_u8(op, opc, spr);
+
+    /* Background shows where the sprite is transparent or behind an opaque high priority pixel */
+    c = vorrq_u8(vmvnq_u8(so), vbicq_u8(vandq_u8(bp, bo), sp));
+    c = vbslq_u8(c, vorrq_u8(bf, bi), spr);
+
+    /* Strip palette bits from transparent pixels */
+    c = vbicq_u8(c, vbicq_u8(m3f, vtstq_u8(c, m0f)));
+
+    vst1q_u8(&dst[i], c);
+  }
+
+  return i;
+}
+
+/* Same results as DRAW_SPRITE_TILE(8,atex,lut[1]), returns the sprite collision flag */
+INLINE int draw_sprite_tile_m5(uint8 *lb, uint8 *src, int atex)
+{
+  const uint8x8_t m0f = vdup_n_u8(0x0F);
+  const uint8x8_t m3f = vdup_n_u8(0x3F);
+  const uint8x8_t m80 = vdup_n_u8(0x80);
+  uint8x8_t s = vld1_u8(src);
+  uint8x8_t b = vld1_u8(lb);
+  uint8x8_t so = vtst_u8(s, m0f);
+  uint8x8_t bs = vtst_u8(b, m80);
+  uint8x8_t c = vand_u8(vorr_u8(s, vdup_n_u8(atex)), m3f);
+
+  /* Low priority sprite is behind opaque high priority background pixels */
+  if (!(atex & 0x40))
+  {
+    uint8x8_t bg = vand_u8(vtst_u8(b, m0f), vtst_u8(b, vdup_n_u8(0x40)));
+    c = vbsl_u8(bg, vand_u8(b, m3f), c);
+  }
+
+  /* Pixels already covered by a sprite are left untouched */
+  c = vorr_u8(c, m80);
+  vst1_u8(lb, vbsl_u8(vbic_u8(so, bs), c, b));
+
+  return vget_lane_u64(vreinterpret_u64_u8(vand_u8(so, bs)), 0) ? 0x20 : 0x00;
+}
+
+#else
+
+/* Mode 5 sprite pattern over the sprites already drawn, returns the sprite collision flag */
+INLINE int draw_sprite_tile_m5(uint8 *lb, uint8 *src, int atex)
+{
+  int i;
+  uint32 temp;
+  uint16 collision = 0;
+
+  DRAW_SPRITE_TILE(8,atex,lut[1],collision)
+
+  return collision;
+}
+
+#endif
+
+#ifdef REMAP_AVX2
+/* Same as the remap_line loops, 8 pixels at a time (returns pixels done) */
+__attribute__((target("avx2"))) static int remap_pixels_avx2(uint32 *dst, uint8 *src, int width, int key)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i keyed = _mm256_set1_epi32(PIXEL_KEY);
+  int i;
+
+  for (i = 0; (i + 8) <= width; i += 8)
+  {
+    __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)&src[i]));
+    __m256i color = _mm256_i32gather_epi32((const int *)pixel, index, 4);
+
+    /* Backdrop pixels are replaced by the transparent key pixel */
+    if (key)
+    {
+      color = _mm256_blendv_epi8(color, keyed, _mm256_cmpeq_epi32(index, zero));
+    }
+
+    _mm256_storeu_si256((__m256i *)&dst[i], color);
+  }
+
+  return i;
+}
+
+/* Selected by render_init when the CPU supports it */
+static int (*remap_pixels)(uint32 *dst, uint8 *src, int width, int key);
+#endif
+
 INLINE void merge(uint8 *srca, uint8 *srcb, uint8 *dst, uint8 *table, int width)
 {
+#if defined(RENDER_SSE2) || defined(RENDER_NEON)
+  int count = 0;
+
+  if ((table == lut[0]) || (table == lut[2]))
+  {
+    count = merge_bg_simd(srca, srcb, dst, table == lut[2], width);
+  }
+  else if (table == lut[4])
+  {
+    count = merge_bgobj_ste_simd(srca, srcb, dst, width);
+  }
+
+  /* Remaining pixels */
+  if (count == width) return;
+  srca += count;
+  srcb += count;
+  dst += count;
+  width -= count;
+#endif
+
   do
   {
     *dst++ = table[(*srcb++ << 8) | (*srca++)];
@@ -1095,10 +1620,10 @@ void color_update_m4(int index, unsigned int data)
   if (reg[0] & 0x04)
   {
     /* Mode 4 */
-    pixel[0x00 | index] = data;
-    pixel[0x20 | index] = data;
-    pixel[0x80 | index] = data;
-    pixel[0xA0 | index] = data;
+    PIXEL_SET(0x00 | index, data);
+    PIXEL_SET(0x20 | index, data);
+    PIXEL_SET(0x80 | index, data);
+    PIXEL_SET(0xA0 | index, data);
   }
   else
   {
@@ -1106,22 +1631,22 @@ void color_update_m4(int index, unsigned int data)
     if ((index == 0x40) || (index == (0x10 | (reg[7] & 0x0F))))
     {
       /* Update backdrop color */
-      pixel[0x40] = data;
+      PIXEL_SET(0x40, data);
 
       /* Update transparent color */
-      pixel[0x10] = data;
-      pixel[0x30] = data;
-      pixel[0x90] = data;
-      pixel[0xB0] = data;
+      PIXEL_SET(0x10, data);
+      PIXEL_SET(0x30, data);
+      PIXEL_SET(0x90, data);
+      PIXEL_SET(0xB0, data);
     }
 
     if (index & 0x0F)
     {
       /* update non-transparent colors */
-      pixel[0x00 | index] = data;
-      pixel[0x20 | index] = data;
-      pixel[0x80 | index] = data;
-      pixel[0xA0 | index] = data;
+      PIXEL_SET(0x00 | index, data);
+      PIXEL_SET(0x20 | index, data);
+      PIXEL_SET(0x80 | index, data);
+      PIXEL_SET(0xA0 | index, data);
     }
   }
 }
@@ -1138,9 +1663,9 @@ void color_update_m5(int index, unsigned int data)
   if(reg[12] & 0x08)
   {
     /* Mode 5 (Shadow/Normal/Highlight) */
-    pixel[0x00 | index] = pixel_lut[0][data];
-    pixel[0x40 | index] = pixel_lut[1][data];
-    pixel[0x80 | index] = pixel_lut[2][data];
+    PIXEL_SET(0x00 | index, pixel_lut[0][data]);
+    PIXEL_SET(0x40 | index, pixel_lut[1][data]);
+    PIXEL_SET(0x80 | index, pixel_lut[2][data]);
   }
   else
   {
@@ -1148,9 +1673,9 @@ void color_update_m5(int index, unsigned int data)
     data = pixel_lut[1][data];
 
     /* Input pixel: xxiiiiii */
-    pixel[0x00 | index] = data;
-    pixel[0x40 | index] = data;
-    pixel[0x80 | index] = data;
+    PIXEL_SET(0x00 | index, data);
+    PIXEL_SET(0x40 | index, data);
+    PIXEL_SET(0x80 | index, data);
   }
 }
 
@@ -1522,7 +2047,7 @@ void render_bg_m5(int line)
   /* Common data */
   uint32 xscroll      = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
   if (render_obj == render_obj_m5) {
-    xscroll += 40 + (40 << 16);
+    xscroll += SCREEN_MARGIN + (SCREEN_MARGIN << 16);
   }
   uint32 yscroll      = *(uint32 *)&vsram[0];
   uint32 pf_col_mask  = playfield_col_mask;
@@ -1535,7 +2060,7 @@ void render_bg_m5(int line)
 
   /* Plane B width */
   int start = 0;
-  int end = bitmap.viewport.w >> 4;
+  int end = (bitmap.viewport.w + 15) >> 4;
 
   /* Plane B scroll */
 #ifdef LSB_FIRST
@@ -1677,7 +2202,7 @@ void render_bg_m5_vs(int line)
   /* Common data */
   uint32 xscroll      = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
   if (render_obj == render_obj_m5_ste) {
-    xscroll += 40 + (40 << 16);
+    xscroll += SCREEN_MARGIN + (SCREEN_MARGIN << 16);
   }
   uint32 yscroll      = 0;
   uint32 pf_col_mask  = playfield_col_mask;
@@ -1691,7 +2216,7 @@ void render_bg_m5_vs(int line)
 
   /* Plane B width */
   int start = 0;
-  int end = bitmap.viewport.w >> 4;
+  int end = (bitmap.viewport.w + 15) >> 4;
 
   /* Plane B horizontal scroll */
 #ifdef LSB_FIRST
@@ -1870,7 +2395,7 @@ void render_bg_m5_im2(int line)
   int odd = odd_frame;
   uint32 xscroll      = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
   if (render_obj == render_obj_m5_im2) {
-    xscroll += 40 + (40 << 16);
+    xscroll += SCREEN_MARGIN + (SCREEN_MARGIN << 16);
   }
   uint32 yscroll      = *(uint32 *)&vsram[0];
   uint32 pf_col_mask  = playfield_col_mask;
@@ -1883,7 +2408,7 @@ void render_bg_m5_im2(int line)
 
   /* Plane B width */
   int start = 0;
-  int end = bitmap.viewport.w >> 4;
+  int end = (bitmap.viewport.w + 15) >> 4;
 
   /* Plane B scroll */
 #ifdef LSB_FIRST
@@ -2026,7 +2551,7 @@ void render_bg_m5_im2_vs(int line)
   int odd = odd_frame;
   uint32 xscroll      = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
   if (render_obj == render_obj_m5_im2_ste) {
-    xscroll += 40 + (40 << 16);
+    xscroll += SCREEN_MARGIN + (SCREEN_MARGIN << 16);
   }
   uint32 yscroll      = 0;
   uint32 pf_col_mask  = playfield_col_mask;
@@ -2040,7 +2565,7 @@ void render_bg_m5_im2_vs(int line)
 
   /* Plane B width */
   int start = 0;
-  int end = bitmap.viewport.w >> 4;
+  int end = (bitmap.viewport.w + 15) >> 4;
 
   /* Plane B horizontal scroll */
 #ifdef LSB_FIRST
@@ -2223,7 +2748,7 @@ void render_bg_m5(int line)
   uint32 xscroll      = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
 
   if (render_obj == render_obj_m5) {
-    xscroll += 40 + (40 << 16);
+    xscroll += SCREEN_MARGIN + (SCREEN_MARGIN << 16);
   }
 
   uint32 yscroll      = *(uint32 *)&vsram[0];
@@ -2232,7 +2757,7 @@ void render_bg_m5(int line)
   uint32 pf_shift     = playfield_shift;
 
   /* Number of columns to draw */
-  int width = bitmap.viewport.w >> 4;
+  int width = (bitmap.viewport.w + 15) >> 4;
 
   /* Layer priority table */
   uint8 *table = lut[(reg[12] & 8) >> 2];
@@ -2384,7 +2909,7 @@ void render_bg_m5_vs(int line)
   /* Scroll Planes common data */
   uint32 xscroll      = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
   if (render_obj == render_obj_m5_ste) {
-    xscroll += 40 + (40 << 16);
+    xscroll += SCREEN_MARGIN + (SCREEN_MARGIN << 16);
   }
   uint32 yscroll      = 0;
   uint32 pf_col_mask  = playfield_col_mask;
@@ -2393,7 +2918,7 @@ void render_bg_m5_vs(int line)
   uint32 *vs          = (uint32 *)&vsram[0];
 
   /* Number of columns to draw */
-  int width = bitmap.viewport.w >> 4;
+  int width = (bitmap.viewport.w + 15) >> 4;
 
   /* Layer priority table */
   uint8 *table = lut[(reg[12] & 8) >> 2];
@@ -2582,7 +3107,7 @@ void render_bg_m5_im2(int line)
   int odd = odd_frame;
   uint32 xscroll      = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
   if (render_obj == render_obj_m5_im2) {
-    xscroll += 40 + (40 << 16);
+    xscroll += SCREEN_MARGIN + (SCREEN_MARGIN << 16);
   }
   uint32 yscroll      = *(uint32 *)&vsram[0];
   uint32 pf_col_mask  = playfield_col_mask;
@@ -2590,7 +3115,7 @@ void render_bg_m5_im2(int line)
   uint32 pf_shift     = playfield_shift;
 
   /* Number of columns to draw */
-  int width = bitmap.viewport.w >> 4;
+  int width = (bitmap.viewport.w + 15) >> 4;
 
   /* Layer priority table */
   uint8 *table = lut[(reg[12] & 8) >> 2];
@@ -2743,7 +3268,7 @@ void render_bg_m5_im2_vs(int line)
   int odd = odd_frame;
   uint32 xscroll      = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
   if (render_obj == render_obj_m5_im2_ste) {
-    xscroll += 40 + (40 << 16);
+    xscroll += SCREEN_MARGIN + (SCREEN_MARGIN << 16);
   }
   uint32 yscroll      = 0;
   uint32 pf_col_mask  = playfield_col_mask;
@@ -2752,7 +3277,7 @@ void render_bg_m5_im2_vs(int line)
   uint32 *vs          = (uint32 *)&vsram[0];
 
   /* Number of columns to draw */
-  int width = bitmap.viewport.w >> 4;
+  int width = (bitmap.viewport.w + 15) >> 4;
 
   /* Layer priority table */
   uint8 *table = lut[(reg[12] & 8) >> 2];
@@ -3187,7 +3712,7 @@ void render_obj_m4(int line)
 
 void render_obj_m5(int line)
 {
-  int i, column;
+  int column;
   int xpos, width;
   int pixelcount = 0;
   int masked = 0;
@@ -3220,7 +3745,7 @@ void render_obj_m5(int line)
     }
 
     /* Display area offset */
-    xpos = xpos - 0x80 + 40;
+    xpos = xpos - 0x80 + SCREEN_MARGIN;
 
     // if (xpos < 32) printf("%i\n", xpos + width);
 
@@ -3274,8 +3799,8 @@ void render_obj_m5(int line)
       for (column = 0; column < width; column++, lb+=8)
       {
         temp = attr | ((name + s[column]) & 0x07FF);
-        src = &bg_pattern_cache[(temp << 6) | (v_line)];
-        DRAW_SPRITE_TILE(8,atex,lut[1])
+        src = BG_PATTERN_M5((temp << 6) | (v_line));
+        SPRITE_STATUS |= draw_sprite_tile_m5(lb, src, atex);
       }
     }
 
@@ -3386,8 +3911,8 @@ void render_obj_m5_ste(int line)
       for (column = 0; column < width; column++, lb+=8)
       {
         temp = attr | ((name + s[column]) & 0x07FF);
-        src = &bg_pattern_cache[(temp << 6) | (v_line)];
-        DRAW_SPRITE_TILE(8,atex,lut[3])
+        src = BG_PATTERN_M5((temp << 6) | (v_line));
+        DRAW_SPRITE_TILE(8,atex,lut[3],SPRITE_STATUS)
       }
     }
 
@@ -3417,7 +3942,7 @@ void render_obj_m5_ste(int line)
 
 void render_obj_m5_im2(int line)
 {
-  int i, column;
+  int column;
   int xpos, width;
   int pixelcount = 0;
   int masked = 0;
@@ -3451,7 +3976,7 @@ void render_obj_m5_im2(int line)
     }
 
     /* Display area offset */
-    xpos = xpos - 0x80 + 40;
+    xpos = xpos - 0x80 + SCREEN_MARGIN;
 
     /* Sprite size */
     temp = object_info->size;
@@ -3502,8 +4027,8 @@ void render_obj_m5_im2(int line)
       for(column = 0; column < width; column ++, lb+=8)
       {
         temp = attr | (((name + s[column]) & 0x3ff) << 1);
-        src = &bg_pattern_cache[((temp << 6) | (v_line)) ^ ((attr & 0x1000) >> 6)];
-        DRAW_SPRITE_TILE(8,atex,lut[1])
+        src = BG_PATTERN_M5(((temp << 6) | (v_line)) ^ ((attr & 0x1000) >> 6));
+        SPRITE_STATUS |= draw_sprite_tile_m5(lb, src, atex);
       }
     }
 
@@ -3564,7 +4089,7 @@ void render_obj_m5_im2_ste(int line)
     }
 
     /* Display area offset */
-    xpos = xpos - 0x80 + 40;
+    xpos = xpos - 0x80 + SCREEN_MARGIN;
 
     /* Sprite size */
     temp = object_info->size;
@@ -3615,8 +4140,8 @@ void render_obj_m5_im2_ste(int line)
       for(column = 0; column < width; column ++, lb+=8)
       {
         temp = attr | (((name + s[column]) & 0x3ff) << 1);
-        src = &bg_pattern_cache[((temp << 6) | (v_line)) ^ ((attr & 0x1000) >> 6)];
-        DRAW_SPRITE_TILE(8,atex,lut[3])
+        src = BG_PATTERN_M5(((temp << 6) | (v_line)) ^ ((attr & 0x1000) >> 6));
+        DRAW_SPRITE_TILE(8,atex,lut[3],SPRITE_STATUS)
       }
     }
 
@@ -3826,19 +4351,77 @@ void parse_satb_m4(int line)
   object_count[(line + 1) & 1] = count;
 }
 
-void parse_satb_m5(int line)
+static void sprite_index_update(void)
 {
-  /* Y position */
-  int ypos;
+  /* max. number of parsed sprites (64 or 80 sprites per line by default) */
+  int total = max_sprite_pixels >> 2;
 
-  /* Sprite height (8,16,24,32 pixels)*/
-  int height;
+  /* Parsing stops at link #0 or past the last entry of the display width */
+  int key = (bitmap.viewport.w << 8) | (total << 1) | im2_flag;
 
-  /* Sprite size data */
-  int size;
+  /* Pointer to internal RAM */
+  uint16 *q = (uint16 *) &sat[0];
 
-  /* Sprite link data */
+  uint8 list[128];
+  uint16 next[SPRITE_INDEX_LINES];
   int link = 0;
+  int count = 0;
+  int i, y, ypos, height;
+
+  if (!sprite_index_dirty && (key == sprite_index_key)) return;
+
+  /* Sprites in link order, as the list would be walked for each line */
+  do
+  {
+    list[count++] = link >> 2;
+    link = (q[link + 1] & 0x7F) << 2;
+    if ((link == 0) || (link >= bitmap.viewport.w)) break;
+  }
+  while (--total && (count < 128));
+
+  /* Number of sprites on each line */
+  memset(sprite_index_start, 0, sizeof(sprite_index_start));
+  for (i = 0; i < count; i++)
+  {
+    link = list[i] << 2;
+    ypos = (q[link] >> im2_flag) & 0x1FF;
+    height = 8 + (((q[link + 1] >> 8) & 3) << 3);
+    for (y = ypos; y < ypos + height; y++)
+    {
+      sprite_index_start[y + 1]++;
+    }
+  }
+
+  /* Bucket boundaries */
+  for (y = 0; y < SPRITE_INDEX_LINES; y++)
+  {
+    next[y] = sprite_index_start[y];
+    sprite_index_start[y + 1] += sprite_index_start[y];
+  }
+
+  /* Fill buckets, keeping link order */
+  for (i = 0; i < count; i++)
+  {
+    link = list[i] << 2;
+    ypos = (q[link] >> im2_flag) & 0x1FF;
+    height = 8 + (((q[link + 1] >> 8) & 3) << 3);
+    for (y = ypos; y < ypos + height; y++)
+    {
+      sprite_index[next[y]++] = list[i];
+    }
+  }
+
+  sprite_index_key = key;
+  sprite_index_dirty = 0;
+}
+
+void parse_satb_m5(int line)
+{
+  /* Y range */
+  int ypos;
+
+  /* Sprite link data */
+  int link;
 
   /* Sprite counter */
   int count = 0;
@@ -3846,8 +4429,8 @@ void parse_satb_m5(int line)
   /* max. number of rendered sprites (16 or 20 sprites per line by default) */
   int max = MODE5_MAX_SPRITES_PER_LINE;
 
-  /* max. number of parsed sprites (64 or 80 sprites per line by default) */
-  int total = max_sprite_pixels >> 2;
+  /* Bucket of next line */
+  int i, end;
 
   /* Pointer to sprite attribute table */
   uint16 *p = (uint16 *) &vram[satb];
@@ -3858,57 +4441,40 @@ void parse_satb_m5(int line)
   /* Sprite list for next line */
   object_info_t *object_info = obj_info[(line + 1) & 1];
 
+  /* Rebuild line index after SAT changes */
+  sprite_index_update();
+
   /* Adjust line offset */
   line += 0x81;
 
-  do
-  {
-    /* Read Y position from internal SAT cache */
-    ypos = (q[link] >> im2_flag) & 0x1FF;
+  /* Lines past the index can't be reached by any sprite */
+  i = (line < SPRITE_INDEX_LINES) ? sprite_index_start[line] : 0;
+  end = (line < SPRITE_INDEX_LINES) ? sprite_index_start[line + 1] : 0;
 
-    /* Check if sprite Y position has been reached */
-    if (line >= ypos)
+  for (; i < end; i++)
+  {
+    /* Sprite overflow */
+    if (count == max)
     {
-      /* Read sprite size from internal SAT cache */
-      size = q[link + 1] >> 8;
-
-      /* Sprite height */
-      height = 8 + ((size & 3) << 3);
-
-      /* Y range */
-      ypos = line - ypos;
-
-      /* Check if sprite is visible on current line */
-      if (ypos < height)
-      {
-        /* Sprite overflow */
-        if (count == max)
-        {
-          status |= 0x40;
-          break;
-        }
-
-        /* Update sprite list (only name, attribute & xpos are parsed from VRAM) */
-        object_info->attr  = p[link + 2];
-        object_info->xpos  = p[link + 3];
-        object_info->ypos  = ypos;
-        object_info->size  = size & 0x0f;
+      SPRITE_STATUS |= 0x40;
+      break;
+    }
 
-        /* Increment Sprite count */
-        ++count;
+    link = sprite_index[i] << 2;
+    ypos = line - ((q[link] >> im2_flag) & 0x1FF);
 
-        /* Next sprite entry */
-        object_info++;
-      }
-    }
+    /* Update sprite list (only name, attribute & xpos are parsed from VRAM) */
+    object_info->attr  = p[link + 2];
+    object_info->xpos  = p[link + 3];
+    object_info->ypos  = ypos;
+    object_info->size  = (q[link + 1] >> 8) & 0x0f;
 
-    /* Read link data from internal SAT cache */
-    link = (q[link + 1] & 0x7F) << 2;
+    /* Increment Sprite count */
+    ++count;
 
-    /* Stop parsing if link data points to first entry (#0) or after the last entry (#64 in H32 mode, #80 in H40 mode) */
-    if ((link == 0) || (link >= bitmap.viewport.w)) break;
+    /* Next sprite entry */
+    object_info++;
   }
-  while (--total);
 
   /* Update sprite count for next line (line value already incremented) */
   object_count[line & 1] = count;
@@ -3973,13 +4539,164 @@ void update_bg_pattern_cache_m4(int index)
   }
 }
 
-void update_bg_pattern_cache_m5(int index)
+/* Expand one pattern line into the cached versions */
+INLINE void update_bg_pattern_line_m5(uint8 *dst, int y, uint32 bp)
 {
-  int i;
-  uint8 x, y, c;
-  uint8 *dst;
-  uint16 name;
-  uint32 bp;
+#if defined(RENDER_SSE2)
+  /* Byteplane data = (msb) p4p5 p6p7 p0p1 p2p3 (lsb) */
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  __m128i v = _mm_cvtsi32_si128(bp);
+  __m128i lo = _mm_and_si128(v, mask);                      /* odd pixels */
+  __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);   /* even pixels */
+
+  /* p0 p1 p2 p3 p4 p5 p6 p7 (in cache byte order) */
+  __m128i n = _mm_shufflelo_epi16(_mm_unpacklo_epi8(hi, lo), 0xB1);
+  _mm_storel_epi64((__m128i *)&dst[0x00000 | (y << 3)], n);        /* vflip=0, hflip=0 */
+#ifndef USE_LAZY_PATTERN_FLIP
+  {
+    /* p7 p6 p5 p4 p3 p2 p1 p0 (in cache byte order) */
+    __m128i h = _mm_shufflelo_epi16(_mm_unpacklo_epi8(lo, hi), 0x4E);
+    _mm_storel_epi64((__m128i *)&dst[0x20000 | (y << 3)], h);        /* vflip=0, hflip=1 */
+    _mm_storel_epi64((__m128i *)&dst[0x40000 | ((y ^ 7) << 3)], n);  /* vflip=1, hflip=0 */
+    _mm_storel_epi64((__m128i *)&dst[0x60000 | ((y ^ 7) << 3)], h);  /* vflip=1, hflip=1 */
+  }
+#endif
+#elif defined(RENDER_NEON)
+  /* Byteplane data = (msb) p4p5 p6p7 p0p1 p2p3 (lsb) */
+  uint8x8_t v = vreinterpret_u8_u32(vdup_n_u32(bp));
+  uint8x8x2_t p = vzip_u8(vand_u8(v, vdup_n_u8(0x0F)), vshr_n_u8(v, 4));
+
+  /* p0 p1 p2 p3 p4 p5 p6 p7 (in cache byte order) */
+  uint8x8_t n = vrev32_u8(p.val[0]);
+  vst1_u8(&dst[0x00000 | (y << 3)], n);         /* vflip=0, hflip=0 */
+#ifndef USE_LAZY_PATTERN_FLIP
+  {
+    /* p7 p6 p5 p4 p3 p2 p1 p0 (in cache byte order) */
+    uint8x8_t h = vrev64_u8(n);
+    vst1_u8(&dst[0x20000 | (y << 3)], h);         /* vflip=0, hflip=1 */
+    vst1_u8(&dst[0x40000 | ((y ^ 7) << 3)], n);   /* vflip=1, hflip=0 */
+    vst1_u8(&dst[0x60000 | ((y ^ 7) << 3)], h);   /* vflip=1, hflip=1 */
+  }
+#endif
+#else
+  int x;
+  uint8 c;
+
+  /* Update cached line (8 pixels = 8 bytes) */
+  for(x = 0; x < 8; x ++)
+  {
+    /* Extract pixel data */
+    c = bp & 0x0F;
+
+    /* Pattern cache data (one pattern = 8 bytes) */
+    /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
+    /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
+#ifdef LSB_FIRST
+    /* Byteplane data = (msb) p4p5 p6p7 p0p1 p2p3 (lsb) */
+    dst[0x00000 | (y << 3) | (x ^ 3)] = (c);        /* vflip=0, hflip=0 */
+#ifndef USE_LAZY_PATTERN_FLIP
+    dst[0x20000 | (y << 3) | (x ^ 4)] = (c);        /* vflip=0, hflip=1 */
+    dst[0x40000 | ((y ^ 7) << 3) | (x ^ 3)] = (c);  /* vflip=1, hflip=0 */
+    dst[0x60000 | ((y ^ 7) << 3) | (x ^ 4)] = (c);  /* vflip=1, hflip=1 */
+#endif
+#else
+    /* Byteplane data = (msb) p0p1 p2p3 p4p5 p6p7 (lsb) */
+    dst[0x00000 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0, hflip=0 */
+#ifndef USE_LAZY_PATTERN_FLIP
+    dst[0x20000 | (y << 3) | (x)] = (c);            /* vflip=0, hflip=1 */
+    dst[0x40000 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1, hflip=0 */
+    dst[0x60000 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1, hflip=1 */
+#endif
+#endif
+    /* Next pixel */
+    bp = bp >> 4;
+  }
+#endif
+}
+
+/* Expand a whole pattern (8 lines) into the cached versions */
+INLINE void update_bg_pattern_m5(uint8 *dst, const uint8 *src)
+{
+#if defined(RENDER_SSE2)
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  int i;
+
+  /* two halves of 4 lines, each one giving 2 x 2 lines */
+  for(i = 0; i < 2; i++)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)&src[i << 4]);
+    __m128i lo = _mm_and_si128(v, mask);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+    __m128i n0 = _mm_unpacklo_epi8(hi, lo);
+    __m128i n1 = _mm_unpackhi_epi8(hi, lo);
+    int y = i << 2;
+
+    n0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(n0, 0xB1), 0xB1);
+    n1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(n1, 0xB1), 0xB1);
+    _mm_storeu_si128((__m128i *)&dst[0x00000 | (y << 3)], n0);
+    _mm_storeu_si128((__m128i *)&dst[0x00000 | ((y + 2) << 3)], n1);
+#ifndef USE_LAZY_PATTERN_FLIP
+    {
+      __m128i h0 = _mm_unpacklo_epi8(lo, hi);
+      __m128i h1 = _mm_unpackhi_epi8(lo, hi);
+
+      h0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(h0, 0x4E), 0x4E);
+      h1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(h1, 0x4E), 0x4E);
+      _mm_storeu_si128((__m128i *)&dst[0x20000 | (y << 3)], h0);
+      _mm_storeu_si128((__m128i *)&dst[0x20000 | ((y + 2) << 3)], h1);
+
+      /* vertically flipped: line pairs go in reverse order */
+      _mm_storeu_si128((__m128i *)&dst[0x40000 | ((6 - y) << 3)], _mm_shuffle_epi32(n0, 0x4E));
+      _mm_storeu_si128((__m128i *)&dst[0x40000 | ((4 - y) << 3)], _mm_shuffle_epi32(n1, 0x4E));
+      _mm_storeu_si128((__m128i *)&dst[0x60000 | ((6 - y) << 3)], _mm_shuffle_epi32(h0, 0x4E));
+      _mm_storeu_si128((__m128i *)&dst[0x60000 | ((4 - y) << 3)], _mm_shuffle_epi32(h1, 0x4E));
+    }
+#endif
+  }
+#elif defined(RENDER_NEON)
+  int i;
+
+  /* two halves of 4 lines, each one giving 2 x 2 lines */
+  for(i = 0; i < 2; i++)
+  {
+    uint8x16_t v = vld1q_u8(&src[i << 4]);
+    uint8x16x2_t p = vzipq_u8(vandq_u8(v, vdupq_n_u8(0x0F)), vshrq_n_u8(v, 4));
+    uint8x16_t n0 = vrev32q_u8(p.val[0]);
+    uint8x16_t n1 = vrev32q_u8(p.val[1]);
+    int y = i << 2;
+
+    vst1q_u8(&dst[0x00000 | (y << 3)], n0);
+    vst1q_u8(&dst[0x00000 | ((y + 2) << 3)], n1);
+#ifndef USE_LAZY_PATTERN_FLIP
+    {
+      uint8x16_t h0 = vrev64q_u8(n0);
+      uint8x16_t h1 = vrev64q_u8(n1);
+
+      vst1q_u8(&dst[0x20000 | (y << 3)], h0);
+      vst1q_u8(&dst[0x20000 | ((y + 2) << 3)], h1);
+
+      /* vertically flipped: line pairs go in reverse order */
+      vst1q_u8(&dst[0x40000 | ((6 - y) << 3)], vextq_u8(n0, n0, 8));
+      vst1q_u8(&dst[0x40000 | ((4 - y) << 3)], vextq_u8(n1, n1, 8));
+      vst1q_u8(&dst[0x60000 | ((6 - y) << 3)], vextq_u8(h0, h0, 8));
+      vst1q_u8(&dst[0x60000 | ((4 - y) << 3)], vextq_u8(h1, h1, 8));
+    }
+#endif
+  }
+#else
+  int y;
+
+  for(y = 0; y < 8; y++)
+    update_bg_pattern_line_m5(dst, y, *(uint32 *)&src[y << 2]);
+#endif
+}
+
+void update_bg_pattern_cache_m5(int index)
+{
+  int i;
+  uint8 y;
+  uint8 *dst;
+  uint16 name;
 
   for(i = 0; i < index; i++)
   {
@@ -3989,151 +4706,650 @@ void update_bg_pattern_cache_m5(int index)
     /* Pattern cache base address */
     dst = &bg_pattern_cache[name << 6];
 
-    /* Check modified lines */
-    for(y = 0; y < 8; y ++)
+    /* Fully rewritten patterns (DMA, tile uploads) are converted at once */
+    if(bg_name_dirty[name] == 0xFF)
     {
-      if(bg_name_dirty[name] & (1 << y))
+      update_bg_pattern_m5(dst, &vram[name << 5]);
+    }
+    else
+    {
+      /* Check modified lines */
+      for(y = 0; y < 8; y ++)
       {
-        /* Byteplane data (one pattern = 4 bytes) */
-        /* LIT_ENDIAN: byte0 (lsb) p2p3 p0p1 p6p7 p4p5 (msb) byte3 */
-        /* BIG_ENDIAN: byte0 (msb) p0p1 p2p3 p4p5 p6p7 (lsb) byte3 */
-        bp = *(uint32 *)&vram[(name << 5) | (y << 2)];
-
-        /* Update cached line (8 pixels = 8 bytes) */
-        for(x = 0; x < 8; x ++)
+        if(bg_name_dirty[name] & (1 << y))
         {
-          /* Extract pixel data */
-          c = bp & 0x0F;
+          /* Byteplane data (one pattern = 4 bytes) */
+          /* LIT_ENDIAN: byte0 (lsb) p2p3 p0p1 p6p7 p4p5 (msb) byte3 */
+          /* BIG_ENDIAN: byte0 (msb) p0p1 p2p3 p4p5 p6p7 (lsb) byte3 */
+          update_bg_pattern_line_m5(dst, y, *(uint32 *)&vram[(name << 5) | (y << 2)]);
+        }
+      }
+    }
 
-          /* Pattern cache data (one pattern = 8 bytes) */
-          /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
-          /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
+#ifdef USE_LAZY_PATTERN_FLIP
+    /* Flipped versions are rebuilt when next used */
+    bg_pattern_flip[name] = 1;
+#endif
+
+    /* Clear modified pattern flag */
+    bg_name_dirty[name] = 0;
+  }
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Window & Plane A clipping update function (Mode 5)                       */
+/*--------------------------------------------------------------------------*/
+
+void window_clip(unsigned int data, unsigned int sw)
+{
+  /* Window size and invert flags */
+  int hp = (data & 0x1f);
+  int hf = (data >> 7) & 1;
+
+  /* Perform horizontal clipping; the results are applied in reverse
+     if the horizontal inversion flag is set
+   */
+  int a = hf;
+  int w = hf ^ 1;
+
+  /* Display width, widescreen columns included */
+  sw = SCREEN_COLUMNS;
+
+  if(hp)
+  {
+    if(hp > sw)
+    {
+      /* Plane W takes up entire line */
+      clip[w].left = 0;
+      clip[w].right = sw;
+      clip[w].enable = 1;
+      clip[a].enable = 0;
+    }
+    else
+    {
+      /* Plane W takes left side, Plane A takes right side */
+      clip[w].left = 0;
+      clip[a].right = sw;
+      clip[a].left = clip[w].right = hp;
+      clip[0].enable = clip[1].enable = 1;
+    }
+  }
+  else
+  {
+    /* Plane A takes up entire line */
+    clip[a].left = 0;
+    clip[a].right = sw;
+    clip[a].enable = 1;
+    clip[w].enable = 0;
+  }
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Init, reset routines                                                     */
+/*--------------------------------------------------------------------------*/
+
+void render_init(void)
+{
+  int bx, ax;
+
+  /* Initialize layers priority pixel look-up tables */
+  uint16 index;
+  for (bx = 0; bx < 0x100; bx++)
+  {
+    for (ax = 0; ax < 0x100; ax++)
+    {
+      index = (bx << 8) | (ax);
+
+      lut[0][index] = make_lut_bg(bx, ax);
+      lut[1][index] = make_lut_bgobj(bx, ax);
+      lut[2][index] = make_lut_bg_ste(bx, ax);
+      lut[3][index] = make_lut_obj(bx, ax);
+      lut[4][index] = make_lut_bgobj_ste(bx, ax);
+      lut[5][index] = make_lut_bgobj_m4(bx,ax);
+    }
+  }
+
+  /* Initialize pixel color look-up tables */
+  palette_init();
+
+  /* Make sprite pattern name index look-up table (Mode 5) */
+  make_name_lut();
+
+  /* Make bitplane to pixel look-up table (Mode 4) */
+  make_bp_lut();
+
+#ifdef REMAP_AVX2
+  /* Pick the palette remap implementation */
+  remap_pixels = __builtin_cpu_supports("avx2") ? remap_pixels_avx2 : NULL;
+#endif
+}
+
+void render_reset(void)
+{
+  /* Clear display bitmap */
+  memset(bitmap.data, 0, bitmap.pitch * bitmap.height);
+
+  /* Clear line buffers */
+  memset(linebuf, 0, sizeof(linebuf));
+
+  /* Clear color palettes */
+  memset(pixel, 0, sizeof(pixel));
+
+  /* Clear pattern cache */
+  memset ((char *) bg_pattern_cache, 0, sizeof (bg_pattern_cache));
+#ifdef USE_LAZY_PATTERN_FLIP
+  memset (bg_pattern_flip, 1, sizeof (bg_pattern_flip));
+#endif
+
+  /* Reset Sprite infos */
+  spr_ovr = spr_col = object_count[0] = object_count[1] = 0;
+
+#ifdef USE_DEFERRED_RENDER
+  /* Drop lines queued before reset */
+  render_pending = 0;
+#endif
+
+#ifdef USE_DIRTY_LINES
+  /* Cleared palette and display bitmap */
+  pixel_key = 0;
+  line_target = NULL;
+  render_dirty_begin();
+#endif
+
+#ifdef USE_GPU_RENDER
+  /* Drop lines captured before reset */
+  memset(gpu_frame.line, 0, sizeof(gpu_frame.line));
+  gpu_frame.lines = 0;
+  gpu_palette_dirty = 1;
+  gpu_patterns = 0;
+#endif
+}
+
+
+#ifdef USE_GPU_RENDER
+/*--------------------------------------------------------------------------*/
+/* GPU line capture (Mode 5)                                                */
+/*--------------------------------------------------------------------------*/
+
+/* Plane A & B halves of a scroll table entry */
 #ifdef LSB_FIRST
-          /* Byteplane data = (msb) p4p5 p6p7 p0p1 p2p3 (lsb) */
-          dst[0x00000 | (y << 3) | (x ^ 3)] = (c);        /* vflip=0, hflip=0 */
-          dst[0x20000 | (y << 3) | (x ^ 4)] = (c);        /* vflip=0, hflip=1 */
-          dst[0x40000 | ((y ^ 7) << 3) | (x ^ 3)] = (c);  /* vflip=1, hflip=0 */
-          dst[0x60000 | ((y ^ 7) << 3) | (x ^ 4)] = (c);  /* vflip=1, hflip=1 */
+#define GPU_HALF_A(data) ((data) & 0xFFFF)
+#define GPU_HALF_B(data) ((data) >> 16)
 #else
-          /* Byteplane data = (msb) p0p1 p2p3 p4p5 p6p7 (lsb) */
-          dst[0x00000 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0, hflip=0 */
-          dst[0x20000 | (y << 3) | (x)] = (c);            /* vflip=0, hflip=1 */
-          dst[0x40000 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1, hflip=0 */
-          dst[0x60000 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1, hflip=1 */
+#define GPU_HALF_A(data) ((data) >> 16)
+#define GPU_HALF_B(data) ((data) & 0xFFFF)
 #endif
-          /* Next pixel */
-          bp = bp >> 4;
+
+/* Both cells of a name table column (see DRAW_COLUMN), with their pattern row */
+#define GPU_COLUMN(ATBUF, ROW) \
+{ \
+  uint16 *n = (uint16 *)&(ATBUF); \
+  *cell++ = n[0] | ((ROW) << 16); \
+  *cell++ = n[1] | ((ROW) << 16); \
+}
+
+const uint8 *render_lut(int index)
+{
+  return lut[index];
+}
+
+void render_gpu_begin(void)
+{
+  memset(gpu_frame.line, 0, gpu_frame.lines * sizeof(t_gpu_line));
+  gpu_frame.lines = 0;
+  gpu_frame.sprites = 0;
+  gpu_frame.palettes = 0;
+  gpu_palette_dirty = 1;
+  gpu_patterns = 0;
+}
+
+/* Framebuffer line of an active line (-1 if it can't be captured) */
+static int gpu_row(int line)
+{
+  /* Interlaced output mixes two fields in the framebuffer */
+  if (interlaced && config_legacy.render) return -1;
+
+  line = (line + bitmap.viewport.y) % lines_per_frame;
+
+  return ((line >= 0) && (line < GPU_LINES_MAX)) ? line : -1;
+}
+
+/* Line is drawn again, by whichever path */
+static void gpu_drop_line(int line)
+{
+  int row = gpu_row(line);
+
+  if (row >= 0) gpu_frame.line[row].flags = 0;
+}
+
+/* Current palette, as the last snapshot (0 when out of snapshots) */
+static int gpu_palette_snapshot(void)
+{
+  if (gpu_palette_dirty)
+  {
+    if (gpu_frame.palettes == GPU_PALETTES_MAX) return 0;
+
+    memcpy(gpu_frame.palette[gpu_frame.palettes++], pixel, sizeof(pixel));
+    gpu_palette_dirty = 0;
+  }
+
+  return 1;
+}
+
+/* Pattern data of the frame, with VRAM byte order undone */
+static void gpu_pattern_snapshot(void)
+{
+  uint32 *src = (uint32 *)vram;
+  int i;
+
+  for (i = 0; i < 0x4000; i++)
+  {
+#ifdef LSB_FIRST
+    gpu_frame.pattern[i] = (src[i] << 16) | (src[i] >> 16);
+#else
+    gpu_frame.pattern[i] = src[i];
+#endif
+  }
+}
+
+/* Same name table fetches as render_bg_m5 & render_bg_m5_vs */
+static void gpu_capture_bg_m5(int line, t_gpu_line *desc, uint32 (*cells)[GPU_CELLS])
+{
+  int column, start, end;
+  uint32 hs, shift, index, v_line, *nt, *cell;
+  int column_vs = (render_bg == render_bg_m5_vs);
+
+  /* Scroll Planes common data */
+  uint32 xscroll      = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
+  uint32 yscroll      = 0;
+  uint32 pf_col_mask  = playfield_col_mask;
+  uint32 pf_row_mask  = playfield_row_mask;
+  uint32 pf_shift     = playfield_shift;
+  uint32 *vs          = (uint32 *)&vsram[0];
+
+  /* Window & Plane A */
+  int a = (reg[18] & 0x1F) << 3;
+  int w = (reg[18] >> 7) & 1;
+
+  /* Widescreen offset, as each renderer applies it */
+  if (render_obj == (column_vs ? render_obj_m5_ste : render_obj_m5))
+  {
+    xscroll += SCREEN_MARGIN + (SCREEN_MARGIN << 16);
+  }
+
+  if (!column_vs)
+  {
+    yscroll = vs[0];
+  }
+  else if (reg[12] & 1)
+  {
+    /* Left-most column vertical scrolling in H40 mode (see render_bg_m5_vs) */
+    yscroll = vs[19] & (vs[19] >> 16);
+  }
+
+  /* Plane B width */
+  start = 0;
+  end = (bitmap.viewport.w + 15) >> 4;
+
+  /* Plane B horizontal scroll */
+  hs = GPU_HALF_B(xscroll);
+  shift = hs & 0x0F;
+  index = pf_col_mask + 1 - ((hs >> 4) & pf_col_mask);
+
+  cell = cells[GPU_PLANE_B];
+  desc->b_pos = 0;
+
+  /* Left-most column, partially shown */
+  if (shift || !column_vs)
+  {
+    v_line = (line + (column_vs ? yscroll : GPU_HALF_B(yscroll))) & pf_row_mask;
+    nt = (uint32 *)&vram[ntbb + (((v_line >> 3) << pf_shift) & 0x1FC0)];
+    GPU_COLUMN(nt[(index - 1) & pf_col_mask], v_line & 7)
+    desc->b_pos = shift - 16;
+  }
+
+  for (column = 0; column < end; column++, index++)
+  {
+    v_line = (line + GPU_HALF_B(column_vs ? vs[column] : yscroll)) & pf_row_mask;
+    nt = (uint32 *)&vram[ntbb + (((v_line >> 3) << pf_shift) & 0x1FC0)];
+    GPU_COLUMN(nt[index & pf_col_mask], v_line & 7)
+  }
+
+  if (w == (line >= a))
+  {
+    /* Window takes up entire line */
+    a = 0;
+    w = 1;
+  }
+  else
+  {
+    /* Window and Plane A share the line */
+    a = clip[0].enable;
+    w = clip[1].enable;
+  }
+
+  desc->a_pos = desc->a_end = 0;
+  desc->w_pos = desc->w_end = 0;
+
+  /* Plane A */
+  if (a)
+  {
+    /* Plane A width */
+    start = clip[0].left;
+    end   = clip[0].right;
+
+    /* Plane A horizontal scroll */
+    hs = GPU_HALF_A(xscroll);
+    shift = hs & 0x0F;
+    index = pf_col_mask + start + 1 - ((hs >> 4) & pf_col_mask);
+
+    cell = cells[GPU_PLANE_A];
+    desc->a_pos = start << 4;
+
+    if (shift)
+    {
+      v_line = (line + (column_vs ? yscroll : GPU_HALF_A(yscroll))) & pf_row_mask;
+      nt = (uint32 *)&vram[ntab + (((v_line >> 3) << pf_shift) & 0x1FC0)];
+
+      /* Window bug */
+      GPU_COLUMN(nt[(start ? index : (index - 1)) & pf_col_mask], v_line & 7)
+      desc->a_pos += shift - 16;
+    }
+
+    for (column = start; column < end; column++, index++)
+    {
+      v_line = (line + GPU_HALF_A(column_vs ? vs[column] : yscroll)) & pf_row_mask;
+      nt = (uint32 *)&vram[ntab + (((v_line >> 3) << pf_shift) & 0x1FC0)];
+      GPU_COLUMN(nt[index & pf_col_mask], v_line & 7)
+    }
+
+    desc->a_end = desc->a_pos + ((cell - cells[GPU_PLANE_A]) << 3);
+
+    /* Window width */
+    start = clip[1].left;
+    end   = clip[1].right;
+  }
+
+  /* Window */
+  if (w)
+  {
+    nt = (uint32 *)&vram[ntwb | ((line >> 3) << (6 + (reg[12] & 1)))];
+
+    cell = cells[GPU_WINDOW];
+    desc->w_pos = start << 4;
+
+    for (column = start; column < end; column++)
+    {
+      GPU_COLUMN(nt[column], line & 7)
+    }
+
+    desc->w_end = desc->w_pos + ((cell - cells[GPU_WINDOW]) << 3);
+  }
+}
+
+/* Sprite collision over one pattern row, as detected while drawing it */
+/* (returns 0 once the flag is raised, nothing more to check then)     */
+static int gpu_sprite_collision(int xpos, uint32 name, uint32 v_line)
+{
+  uint64_t opaque, covered;
+  uint8 *lb = &gpu_sprite_mask[0x20 + xpos];
+
+  memcpy(&opaque, BG_PATTERN_M5((name << 6) | (v_line << 3)), 8);
+  opaque = ((opaque & 0x0F0F0F0F0F0F0F0FULL) + 0x7F7F7F7F7F7F7F7FULL) & 0x8080808080808080ULL;
+
+  memcpy(&covered, lb, 8);
+  if (covered & opaque)
+  {
+    SPRITE_STATUS |= 0x20;
+    return 0;
+  }
+
+  covered |= opaque;
+  memcpy(lb, &covered, 8);
+  return 1;
+}
+
+/* Same sprites, masking & pixel limit as render_obj_m5 & render_obj_m5_ste */
+static void gpu_capture_obj_m5(int line, t_gpu_line *desc, t_gpu_sprite *sprite)
+{
+  int column;
+  int xpos, width;
+  int pixelcount = 0;
+  int masked = 0;
+  int max_pixels = MODE5_MAX_SPRITE_PIXELS;
+  int ste = (render_obj == render_obj_m5_ste);
+  int collision = !(SPRITE_STATUS & 0x20);
+
+  uint8 *s;
+  uint32 temp, v_line;
+  uint32 attr, name, atex;
+
+  /* Sprite list for current line */
+  object_info_t *object_info = obj_info[line];
+  int count = object_count[line];
+
+  desc->sprites = 0;
+
+  if (collision)
+  {
+    memset(gpu_sprite_mask, 0, bitmap.viewport.w + 0x40);
+  }
+
+  /* Draw sprites in front-to-back order */
+  while (count--)
+  {
+    /* Sprite X position */
+    xpos = object_info->xpos;
+
+    /* Sprite masking  */
+    if (xpos)
+    {
+      /* Requires at least one sprite with xpos > 0 */
+      spr_ovr = 1;
+    }
+    else if (spr_ovr)
+    {
+      /* Remaining sprites are not drawn */
+      masked = 1;
+    }
+
+    /* Display area offset */
+    xpos = xpos - 0x80 + (ste ? 0 : SCREEN_MARGIN);
+
+    /* Sprite size */
+    temp = object_info->size;
+
+    /* Sprite width */
+    width = 8 + ((temp & 0x0C) << 1);
+
+    /* Update pixel count (off-screen sprites are included) */
+    pixelcount += width;
+
+    /* Is sprite across visible area ? */
+    if (((xpos + width) > 0) && (xpos < bitmap.viewport.w) && !masked)
+    {
+      /* Sprite attributes */
+      attr = object_info->attr;
+
+      /* Sprite vertical offset */
+      v_line = object_info->ypos;
+
+      /* Sprite priority + palette bits */
+      atex = (attr >> 9) & 0x70;
+
+      /* Pattern name base */
+      name = attr & 0x07FF;
+
+      /* Mask vflip/hflip */
+      attr &= 0x1800;
+
+      /* Pointer into pattern name offset look-up table */
+      s = &name_lut[((attr >> 3) & 0x300) | (temp << 4) | ((v_line & 0x18) >> 1)];
+
+      /* Max. number of sprite pixels rendered per line (not applied with shadow/highlight) */
+      if (!ste && (pixelcount > max_pixels))
+      {
+        width -= (pixelcount - max_pixels);
+      }
+
+      /* Number of tiles to draw */
+      width = width >> 3;
+
+      /* Pattern row index */
+      v_line = v_line & 7;
+
+      if (width > 0)
+      {
+        sprite->x = xpos;
+        sprite->attr = width | (atex << 8) | (v_line << 16);
+        sprite->name[0] = sprite->name[1] = 0;
+
+        for (column = 0; column < width; column++)
+        {
+          temp = attr | ((name + s[column]) & 0x07FF);
+          sprite->name[column >> 1] |= temp << ((column & 1) << 4);
+
+          if (collision)
+          {
+            collision = gpu_sprite_collision(xpos + (column << 3), temp, v_line);
+          }
         }
+
+        sprite++;
+        desc->sprites++;
       }
     }
 
-    /* Clear modified pattern flag */
-    bg_name_dirty[name] = 0;
+    /* Next sprite entry */
+    object_info++;
+  }
+
+  /* Clear sprite masking for next line  */
+  spr_ovr = 0;
+
+  if (desc->sprites > gpu_frame.sprites)
+  {
+    gpu_frame.sprites = desc->sprites;
   }
 }
 
+/* Capture a Mode 5 line instead of drawing it (returns 0 if it has to be drawn) */
+static int gpu_capture_line(int line)
+{
+  t_gpu_line *desc;
+  int row = gpu_row(line);
 
-/*--------------------------------------------------------------------------*/
-/* Window & Plane A clipping update function (Mode 5)                       */
-/*--------------------------------------------------------------------------*/
+  if ((row < 0) || render_bg_disable || bitmap.viewport.x || config_legacy.lcd) return 0;
 
-void window_clip(unsigned int data, unsigned int sw)
-{
-  /* Window size and invert flags */
-  int hp = (data & 0x1f);
-  int hf = (data >> 7) & 1;
+  /* Interlace mode 2 is left to the CPU */
+  if (((render_bg != render_bg_m5) && (render_bg != render_bg_m5_vs)) ||
+      ((render_obj != render_obj_m5) && (render_obj != render_obj_m5_ste)))
+  {
+    return 0;
+  }
 
-  /* Perform horizontal clipping; the results are applied in reverse
-     if the horizontal inversion flag is set
-   */
-  int a = hf;
-  int w = hf ^ 1;
+  if ((gpu_patterns < 0) || !gpu_palette_snapshot()) return 0;
 
-  /* Display width (16 or 20 columns) */
-  sw = 25;
+  if (!gpu_patterns)
+  {
+    gpu_pattern_snapshot();
+    gpu_patterns = 1;
+  }
 
-  if(hp)
+  desc = &gpu_frame.line[row];
+  desc->flags = GPU_LINE_CAPTURED;
+  desc->palette = gpu_frame.palettes - 1;
+  desc->blank_pos = desc->blank_end = 0;
+
+  if (reg[12] & 0x08)
   {
-    if(hp > sw)
-    {
-      /* Plane W takes up entire line */
-      clip[w].left = 0;
-      clip[w].right = sw;
-      clip[w].enable = 1;
-      clip[a].enable = 0;
-    }
-    else
-    {
-      /* Plane W takes left side, Plane A takes right side */
-      clip[w].left = 0;
-      clip[a].right = sw;
-      clip[a].left = clip[w].right = hp;
-      clip[0].enable = clip[1].enable = 1;
-    }
+    desc->flags |= GPU_LINE_BG_STE;
   }
-  else
+
+  if (render_obj == render_obj_m5_ste)
   {
-    /* Plane A takes up entire line */
-    clip[a].left = 0;
-    clip[a].right = sw;
-    clip[a].enable = 1;
-    clip[w].enable = 0;
+    desc->flags |= GPU_LINE_OBJ_STE;
   }
-}
 
+  gpu_capture_bg_m5(line, desc, gpu_frame.cells[row]);
+  gpu_capture_obj_m5(line & 1, desc, gpu_frame.sprite[row]);
 
-/*--------------------------------------------------------------------------*/
-/* Init, reset routines                                                     */
-/*--------------------------------------------------------------------------*/
+  if (row >= gpu_frame.lines)
+  {
+    gpu_frame.lines = row + 1;
+  }
 
-void render_init(void)
+  return 1;
+}
+
+/* Captured line is needed in the framebuffer after all (out of palette snapshots) */
+static void gpu_release_line(int line)
 {
-  int bx, ax;
+  t_gpu_line *desc;
+  int collision;
+  int row = gpu_row(line);
 
-  /* Initialize layers priority pixel look-up tables */
-  uint16 index;
-  for (bx = 0; bx < 0x100; bx++)
-  {
-    for (ax = 0; ax < 0x100; ax++)
-    {
-      index = (bx << 8) | (ax);
+  if ((row < 0) || !gpu_frame.line[row].flags) return;
 
-      lut[0][index] = make_lut_bg(bx, ax);
-      lut[1][index] = make_lut_bgobj(bx, ax);
-      lut[2][index] = make_lut_bg_ste(bx, ax);
-      lut[3][index] = make_lut_obj(bx, ax);
-      lut[4][index] = make_lut_bgobj_ste(bx, ax);
-      lut[5][index] = make_lut_bgobj_m4(bx,ax);
-    }
-  }
+  desc = &gpu_frame.line[row];
+  desc->flags = 0;
 
-  /* Initialize pixel color look-up tables */
-  palette_init();
+  render_bg(line);
 
-  /* Make sprite pattern name index look-up table (Mode 5) */
-  make_name_lut();
+  /* Sprite collision was already flagged when the line was captured */
+  collision = SPRITE_STATUS & 0x20;
+  render_obj(line & 1);
+  SPRITE_STATUS = (SPRITE_STATUS & ~0x20) | collision;
 
-  /* Make bitplane to pixel look-up table (Mode 4) */
-  make_bp_lut();
+  if (desc->blank_end > desc->blank_pos)
+  {
+    memset(&linebuf[0][0x20 + desc->blank_pos], 0x40, desc->blank_end - desc->blank_pos);
+  }
 }
 
-void render_reset(void)
+/* Captured line partially blanked (returns 0 if it isn't captured) */
+static int gpu_blank_line(int line, int offset, int width)
 {
-  /* Clear display bitmap */
-  memset(bitmap.data, 0, bitmap.pitch * bitmap.height);
+  t_gpu_line *desc;
+  int end = offset + width;
+  int row = gpu_row(line);
 
-  /* Clear line buffers */
-  memset(linebuf, 0, sizeof(linebuf));
+  if ((row < 0) || !gpu_frame.line[row].flags) return 0;
 
-  /* Clear color palettes */
-  memset(pixel, 0, sizeof(pixel));
+  desc = &gpu_frame.line[row];
 
-  /* Clear pattern cache */
-  memset ((char *) bg_pattern_cache, 0, sizeof (bg_pattern_cache));
+  /* Display turned off then back on within the line */
+  if (desc->blank_end > desc->blank_pos)
+  {
+    if (desc->blank_pos < offset) offset = desc->blank_pos;
+    if (desc->blank_end > end) end = desc->blank_end;
+  }
 
-  /* Reset Sprite infos */
-  spr_ovr = spr_col = object_count[0] = object_count[1] = 0;
+  desc->blank_pos = offset;
+  desc->blank_end = end;
+  return 1;
+}
+
+/* Captured line remapped with the current palette (backdrop color changed during HBLANK) */
+static int gpu_remap_line(int line)
+{
+  int row = gpu_row(line);
+
+  if ((row < 0) || !gpu_frame.line[row].flags) return 0;
+
+  if (!gpu_palette_snapshot())
+  {
+    /* Out of snapshots, remapped as usual */
+    gpu_release_line(line);
+    return 0;
+  }
+
+  gpu_frame.line[row].palette = gpu_frame.palettes - 1;
+  return 1;
 }
+#endif
 
 
 /*--------------------------------------------------------------------------*/
@@ -4142,6 +5358,21 @@ void render_reset(void)
 
 void render_line(int line)
 {
+  RENDER_PROFILER_ENTER();
+
+#ifdef USE_GPU_RENDER
+  if (render_gpu)
+  {
+    gpu_drop_line(line);
+
+    /* Lines captured so far keep the patterns they were captured with */
+    if (bg_list_index && gpu_patterns)
+    {
+      gpu_patterns = -1;
+    }
+  }
+#endif
+
   /* Check display status */
   if (reg[1] & 0x40)
   {
@@ -4152,13 +5383,31 @@ void render_line(int line)
       bg_list_index = 0;
     }
 
+#ifdef USE_GPU_RENDER
+    if (render_gpu && gpu_capture_line(line))
+    {
+      /* Parse sprites for next line */
+      if (line < (bitmap.viewport.h - 1))
+      {
+        parse_satb(line);
+      }
+
+      RENDER_PROFILER_LEAVE();
+      return;
+    }
+#endif
+
     /* Render BG layer(s) */
-    
-    if (render_bg_disable) {
-      pixel[0x00] = MAKE_PIXEL(0xF,0x0,0xF);
-      blank_line(line, 0, bitmap.viewport.w);
-    } else render_bg(line);
-    
+    if (render_bg_disable)
+    {
+      /* Backdrop only: remap_line outputs the transparent key pixel for it, */
+      /* not the backdrop color                                             */
+      memset(&linebuf[0][0x20], 0x00, bitmap.viewport.w);
+    }
+    else
+    {
+      render_bg(line);
+    }
 
     /* Render sprite layer */
     render_obj(line & 1);
@@ -4204,14 +5453,256 @@ void render_line(int line)
 
   /* Pixel color remapping */
   remap_line(line);
+
+  RENDER_PROFILER_LEAVE();
+}
+
+#ifdef USE_DEFERRED_RENDER
+static void render_queue_add(int line, int satb)
+{
+  render_queue_t *entry;
+
+  if (render_pending == RENDER_QUEUE_SIZE)
+  {
+    render_sync();
+  }
+
+  entry = &render_queue[render_pending++];
+  entry->line = line;
+  entry->v_counter = v_counter;
+  entry->odd_frame = odd_frame;
+  entry->satb = satb;
+}
+
+void render_queue_line(int line)
+{
+  render_queue_add(line, 0);
+}
+
+void render_queue_satb(int line)
+{
+  render_queue_add(line, 1);
+}
+
+#ifdef USE_PARALLEL_RENDER
+static void render_band_lines(int index)
+{
+  render_band_t *band = &render_band[index];
+  int i;
+
+  if (index)
+  {
+#ifdef ENABLE_PROFILER
+    render_worker = 1;
+#endif
+
+    /* Sprite flags are merged into status once all bands are done */
+    band->status = 0;
+    spr_status = &band->status;
+
+    /* Sprites of the first line, as parsed at the end of the previous band */
+    if (reg[1] & 0x40)
+    {
+      parse_satb(render_queue[band->first].line - 1);
+    }
+  }
+
+  for (i = band->first; i <= band->last; i++)
+  {
+    render_line(render_queue[i].line);
+  }
+
+  band->linebuf = &linebuf[0][0];
+  band->obj_info = &obj_info[0][0];
+  band->object_count = object_count;
+}
+
+/* Render queued lines in bands on the render threads (returns 0 if they can't be split) */
+static int render_queue_split(void)
+{
+  render_band_t *band;
+  int first, lines, bands, i;
+
+  /* Mode 5 lines only depend on the line before through the sprite list */
+  if (!(reg[1] & 0x04)) return 0;
+
+  /* Sprites of the first line may still have to be parsed */
+  first = render_queue[0].satb;
+  lines = render_pending - first;
+
+  bands = lines / RENDER_BAND_LINES;
+  if (bands > render_pool_threads()) bands = render_pool_threads();
+  if (bands > RENDER_MAX_BANDS) bands = RENDER_MAX_BANDS;
+  if (bands < 2) return 0;
+
+  /* Consecutive lines of a single field only (interlaced output renders both) */
+  for (i = first; i < render_pending; i++)
+  {
+    if (render_queue[i].satb || (render_queue[i].odd_frame != render_queue[first].odd_frame)) return 0;
+    if ((i > first) && (render_queue[i].line != (render_queue[i - 1].line + 1))) return 0;
+  }
+
+  if (first)
+  {
+    v_counter = render_queue[0].v_counter;
+    odd_frame = render_queue[0].odd_frame;
+    parse_satb(render_queue[0].line);
+  }
+
+  v_counter = render_queue[first].v_counter;
+  odd_frame = render_queue[first].odd_frame;
+
+  /* Pattern cache is shared: update it once, before any band starts */
+  if ((reg[1] & 0x40) && bg_list_index)
+  {
+    update_bg_pattern_cache(bg_list_index);
+    bg_list_index = 0;
+  }
+
+  /* Same for the sprite line index, bands only read it */
+  sprite_index_update();
+
+  for (i = 0; i < bands; i++)
+  {
+    render_band[i].first = first + ((lines * i) / bands);
+    render_band[i].last = first + ((lines * (i + 1)) / bands) - 1;
+  }
+
+  /* Waiting for the render threads counts as rendering */
+  PROFILER_ENTER(PROFILER_RENDER);
+  render_pool_run(render_band_lines, bands);
+  PROFILER_LEAVE();
+
+  for (i = 1; i < bands; i++)
+  {
+    status |= render_band[i].status;
+  }
+
+  /* Carry on from the last band, as if all lines had been rendered here */
+  band = &render_band[bands - 1];
+  memcpy(linebuf, band->linebuf, sizeof(linebuf));
+  memcpy(obj_info, band->obj_info, sizeof(obj_info));
+  memcpy(object_count, band->object_count, sizeof(object_count));
+
+  return 1;
+}
+#endif
+
+void render_sync(void)
+{
+  /* VDP state as seen by the CPUs */
+  uint16 vc = v_counter;
+  int odd = odd_frame;
+  int i = 0;
+
+#ifdef USE_PARALLEL_RENDER
+  /* Whole frames are usually queued in one go */
+  if (render_queue_split())
+  {
+    i = render_pending;
+  }
+#endif
+
+  /* Render queued lines with the VDP state they were queued with, which */
+  /* has not changed since: any access that could change it syncs first  */
+  for (; i < render_pending; i++)
+  {
+    v_counter = render_queue[i].v_counter;
+    odd_frame = render_queue[i].odd_frame;
+
+    if (render_queue[i].satb)
+    {
+      parse_satb(render_queue[i].line);
+    }
+    else
+    {
+      render_line(render_queue[i].line);
+    }
+  }
+
+  render_pending = 0;
+  v_counter = vc;
+  odd_frame = odd;
 }
+#endif
 
 void blank_line(int line, int offset, int width)
 {
+#ifdef USE_GPU_RENDER
+  if (render_gpu && gpu_blank_line(line, offset, width))
+  {
+    /* Blanked span is output as pixel 0x40 by the frontend */
+    remap_line(line);
+    return;
+  }
+#endif
+
   memset(&linebuf[0][0x20 + offset], 0x40, width);
   remap_line(line);
 }
 
+#ifdef USE_DIRTY_LINES
+/* Everything the converted line depends on: pixels, palette and output options */
+static uint64_t remap_key(const uint8 *src, int width)
+{
+  uint64_t key = pixel_key ^ ((uint64_t)width << 32) ^ (render_bg_disable << 1) ^ (config_legacy.ntsc << 2) ^ ((reg[12] & 0x01) << 3);
+  uint64_t data;
+  int i;
+
+  for (i = 0; i < width; i += 8)
+  {
+    /* line buffers have room past the widest line */
+    memcpy(&data, &src[i], 8);
+    key = (key ^ data) * 0x9E3779B97F4A7C15ULL;
+    key ^= key >> 32;
+  }
+
+  /* 0 is kept for lines in an unknown state */
+  return key | 1;
+}
+
+void render_dirty_begin(void)
+{
+  /* Frontend switched to another framebuffer: nothing in it can be trusted */
+  if (bitmap.data != line_target)
+  {
+    memset(line_key, 0, sizeof(line_key));
+    memset(render_dirty, 1, sizeof(render_dirty));
+    line_target = bitmap.data;
+  }
+}
+
+int render_dirty_runs(int (*runs)[2], int max)
+{
+  int line = 0;
+  int count = 0;
+
+  while (line < DIRTY_LINES_MAX)
+  {
+    /* Next dirty line */
+    while ((line < DIRTY_LINES_MAX) && !render_dirty[line]) line++;
+    if (line == DIRTY_LINES_MAX) break;
+
+    /* The last run covers all remaining dirty lines */
+    if (count == max)
+    {
+      int last = DIRTY_LINES_MAX;
+      while (!render_dirty[last - 1]) last--;
+      memset(&render_dirty[line], 0, last - line);
+      runs[count - 1][1] = last - runs[count - 1][0];
+      break;
+    }
+
+    runs[count][0] = line;
+    while ((line < DIRTY_LINES_MAX) && render_dirty[line]) render_dirty[line++] = 0;
+    runs[count][1] = line - runs[count][0];
+    count++;
+  }
+
+  return count;
+}
+#endif
+
 void remap_line(int line)
 {
   /* Line width */
@@ -4220,6 +5711,10 @@ void remap_line(int line)
   /* Pixel line buffer */
   uint8 *src = &linebuf[0][0x20 - bitmap.viewport.x];
 
+#ifdef USE_GPU_RENDER
+  if (render_gpu && gpu_remap_line(line)) return;
+#endif
+
   /* Adjust line offset in framebuffer */
   line = (line + bitmap.viewport.y) % lines_per_frame;
 
@@ -4232,6 +5727,20 @@ void remap_line(int line)
     line = (line * 2) + odd_frame;
   }
 
+#ifdef USE_DIRTY_LINES
+  if (line < DIRTY_LINES_MAX)
+  {
+    /* LCD ghosting blends into the previous output, so it is always redone */
+    uint64_t key = config_legacy.lcd ? 0 : remap_key(src, width);
+
+    /* Line already holds these pixels */
+    if (key && (key == line_key[line])) return;
+
+    line_key[line] = key;
+    render_dirty[line] = 1;
+  }
+#endif
+
 #if defined(USE_15BPP_RENDERING) || defined(USE_16BPP_RENDERING)
   /* NTSC Filter (only supported for 15 or 16-bit pixels rendering) */
   if (config_legacy.ntsc)
@@ -4253,6 +5762,18 @@ void remap_line(int line)
 #else
     /* Convert VDP pixel data to output pixel format */
     PIXEL_OUT_T *dst = ((PIXEL_OUT_T *)&bitmap.data[(line * bitmap.pitch)]);
+#ifdef REMAP_AVX2
+    if (remap_pixels && !config_legacy.lcd)
+    {
+      int count = remap_pixels(dst, src, width, render_bg_disable);
+
+      /* Remaining pixels */
+      if (count == width) return;
+      dst += count;
+      src += count;
+      width -= count;
+    }
+#endif
     if (config_legacy.lcd)
     {
       do
@@ -4261,6 +5782,16 @@ void remap_line(int line)
       }
       while (--width);
     }
+    else if (render_bg_disable)
+    {
+      /* Backdrop pixels are replaced by the transparent key pixel */
+      do
+      {
+        *dst++ = *src ? pixel[*src] : PIXEL_KEY;
+        src++;
+      }
+      while (--width);
+    }
     else
     {
       do
@@ -4272,3 +5803,39 @@ void remap_line(int line)
  #endif
   }
 }
+
+#ifdef USE_CORE_CONTEXT
+void vdp_render_context_regions(void)
+{
+  CONTEXT_REGION(clip);
+  CONTEXT_REGION(bg_pattern_cache);
+#ifdef USE_LAZY_PATTERN_FLIP
+  CONTEXT_REGION(bg_pattern_flip);
+#endif
+  CONTEXT_REGION(pixel);
+#ifdef USE_DIRTY_LINES
+  CONTEXT_REGION(pixel_key);
+  CONTEXT_REGION(line_key);
+  CONTEXT_REGION(line_target);
+  CONTEXT_REGION(render_dirty);
+#endif
+  CONTEXT_REGION(linebuf);
+  CONTEXT_REGION(spr_ovr);
+  CONTEXT_REGION(render_bg_disable);
+  CONTEXT_REGION(obj_info);
+  CONTEXT_REGION(object_count);
+  CONTEXT_REGION(sprite_index_start);
+  CONTEXT_REGION(sprite_index);
+  CONTEXT_REGION(sprite_index_key);
+  CONTEXT_REGION(sprite_index_dirty);
+  CONTEXT_REGION(spr_col);
+  CONTEXT_REGION(render_bg);
+  CONTEXT_REGION(render_obj);
+  CONTEXT_REGION(parse_satb);
+  CONTEXT_REGION(update_bg_pattern_cache);
+#ifdef USE_DEFERRED_RENDER
+  CONTEXT_REGION(render_queue);
+  CONTEXT_REGION(render_pending);
+#endif
+}
+#endif
@@ -42,9 +42,14 @@
 #ifndef _RENDER_H_
 #define _RENDER_H_
 
+/* Transparent key pixel (PIXEL_KEY) is output instead of the backdrop color while */
+/* background layers are disabled. Its alpha channel is cleared on formats that     */
+/* have one, so backends can upload frames as-is; others fall back to magenta.      */
+
 /* 3:3:2 RGB */
 #if defined(USE_8BPP_RENDERING)
 #define PIXEL(r,g,b) (((r) << 5) | ((g) << 2) | (b))
+#define PIXEL_KEY    PIXEL(7,0,3)
 #define GET_R(pixel) (((pixel) & 0xe0) >> 5)
 #define GET_G(pixel) (((pixel) & 0x1c) >> 2)
 #define GET_B(pixel) (((pixel) & 0x03) >> 0)
@@ -62,21 +67,31 @@
 #define GET_G(pixel) (((pixel) & 0x03e0) >> 5)
 #define GET_B(pixel) (((pixel) & 0x001f) >> 0)
 #endif
+#define PIXEL_KEY    (PIXEL(0x1f,0,0x1f) & ~(1 << 15))
 
 /* 5:6:5 RGB */
 #elif defined(USE_16BPP_RENDERING)
 #define PIXEL(r,g,b) (((r) << 11) | ((g) << 5) | (b))
+#define PIXEL_KEY    PIXEL(0x1f,0,0x1f)
 #define GET_R(pixel) (((pixel) & 0xf800) >> 11)
 #define GET_G(pixel) (((pixel) & 0x07e0) >> 5)
 #define GET_B(pixel) (((pixel) & 0x001f) >> 0)
 
 /* 8:8:8 RGB */
 #elif defined(USE_32BPP_RENDERING)
+#if defined(USE_ABGR)
+#define PIXEL(r,g,b) ((0xff << 24) | ((b) << 16) | ((g) << 8) | (r))
+#define GET_B(pixel) (((pixel) & 0xff0000) >> 16)
+#define GET_G(pixel) (((pixel) & 0x00ff00) >> 8)
+#define GET_R(pixel) (((pixel) & 0x0000ff) >> 0)
+#else
 #define PIXEL(r,g,b) ((0xff << 24) | ((r) << 16) | ((g) << 8) | (b))
 #define GET_R(pixel) (((pixel) & 0xff0000) >> 16)
 #define GET_G(pixel) (((pixel) & 0x00ff00) >> 8)
 #define GET_B(pixel) (((pixel) & 0x0000ff) >> 0)
 #endif
+#define PIXEL_KEY    (PIXEL(0xff,0,0xff) & 0x00ffffff)
+#endif
 
 /* LCD image persistence (ghosting) filter */
 /* Simulates (roughly) the slow decay response time of passive-matrix LCD */
@@ -98,8 +113,15 @@
   *out++ = PIXEL(r,g,b); \
 }
 
+/* Widescreen Mode 5 display: the 320 pixel H40 screen is centered in   */
+/* config_legacy.screen_width pixels, extra columns split on both sides */
+#define SCREEN_WIDTH_MAX 480
+#define SCREEN_MARGIN    ((config_legacy.screen_width - 320) >> 1)
+#define SCREEN_COLUMNS   ((config_legacy.screen_width + 15) >> 4)
+
 /* Global variables */
-extern uint16 spr_col;
+extern CONTEXT_LOCAL uint16 spr_col;
+extern CONTEXT_LOCAL uint8 sprite_index_dirty;
 
 /* Function prototypes */
 extern void render_init(void);
@@ -135,11 +157,114 @@ extern void color_update_m4(int index, unsigned int data);
 extern void color_update_m5(int index, unsigned int data);
 
 /* Function pointers */
-extern void (*render_bg)(int line);
-extern void (*render_obj)(int line);
-extern void (*parse_satb)(int line);
-extern void (*update_bg_pattern_cache)(int index);
+extern CONTEXT_LOCAL void (*render_bg)(int line);
+extern CONTEXT_LOCAL void (*render_obj)(int line);
+extern CONTEXT_LOCAL void (*parse_satb)(int line);
+extern CONTEXT_LOCAL void (*update_bg_pattern_cache)(int index);
+
+extern CONTEXT_LOCAL int render_bg_disable;
 
-extern int render_bg_disable;
+#ifdef USE_DEFERRED_RENDER
+/* Deferred rendering: active lines are queued during the frame and only  */
+/* rendered when the VDP is about to be accessed, or at the end of frame */
+extern CONTEXT_LOCAL int render_pending;
+extern void render_queue_line(int line);
+extern void render_queue_satb(int line);
+extern void render_sync(void);
+#define RENDER_LINE(line) render_queue_line(line)
+#define PARSE_SATB(line)  render_queue_satb(line)
+#define RENDER_SYNC()     do { if (render_pending) render_sync(); } while (0)
+#else
+#define RENDER_LINE(line) render_line(line)
+#define PARSE_SATB(line)  parse_satb(line)
+#define RENDER_SYNC()
+#endif
+
+#ifdef USE_DIRTY_LINES
+/* Dirty line tracking: remap_line leaves framebuffer lines alone when they */
+/* would be converted from the same pixels as last time, and flags the     */
+/* others until the frontend collects them as (first line, count) runs     */
+#define DIRTY_LINES_MAX 640
+extern CONTEXT_LOCAL uint8 render_dirty[DIRTY_LINES_MAX];
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern void render_dirty_begin(void);
+extern int render_dirty_runs(int (*runs)[2], int max);
+#ifdef __cplusplus
+}
+#endif
+#define RENDER_DIRTY_BEGIN() render_dirty_begin()
+#else
+#define RENDER_DIRTY_BEGIN()
+#endif
+
+#ifdef USE_GPU_RENDER
+/* GPU compositing: while render_gpu is set, Mode 5 lines are not drawn but  */
+/* captured as the cells and sprites that make them, for the frontend to    */
+/* composite on the GPU. Lines that can't be captured (interlace mode 2,    */
+/* disabled display, ...) are still drawn into the framebuffer and flagged  */
+/* as such. Pattern data is a snapshot taken at the first captured line;  */
+/* once VRAM is written after it, the rest of the frame is drawn as usual. */
+#define GPU_LINES_MAX    256
+#define GPU_CELLS        64
+#define GPU_SPRITES_MAX  80
+#define GPU_PALETTES_MAX 32
+
+/* Line flags (0 = line is in the framebuffer) */
+#define GPU_LINE_CAPTURED 0x01
+#define GPU_LINE_BG_STE   0x02  /* shadow/highlight background priority */
+#define GPU_LINE_OBJ_STE  0x04  /* shadow/highlight sprites */
+
+/* Layer cells */
+#define GPU_PLANE_B 0
+#define GPU_PLANE_A 1
+#define GPU_WINDOW  2
+
+typedef struct
+{
+  int32 flags;
+  int32 palette;      /* palette snapshot */
+  int32 sprites;      /* sprite count */
+  int32 b_pos;        /* first plane B cell pixel (cells follow each other) */
+  int32 a_pos, a_end; /* plane A cells pixel span */
+  int32 w_pos, w_end; /* window cells pixel span, drawn over plane A */
+  int32 blank_pos, blank_end; /* blanked pixel span (display turned on/off mid-line) */
+  int32 unused[2];    /* whole RGBA32I texels */
+} t_gpu_line;
+
+typedef struct
+{
+  int32 x;            /* first pixel */
+  uint32 attr;        /* 8-pixel columns drawn, priority & palette bits << 8, pattern row << 16 */
+  uint32 name[2];     /* pattern name & flip bits of each column, two per word, low half first */
+} t_gpu_sprite;
+
+typedef struct
+{
+  int lines;          /* lines captured up to (framebuffer lines) */
+  int sprites;        /* most sprites drawn on a line */
+  int palettes;       /* palette snapshots */
+  t_gpu_line line[GPU_LINES_MAX];
+  uint32 cells[GPU_LINES_MAX][3][GPU_CELLS];  /* name table word | pattern row << 16 */
+  t_gpu_sprite sprite[GPU_LINES_MAX][GPU_SPRITES_MAX];
+  uint32 palette[GPU_PALETTES_MAX][0x100];
+  uint32 pattern[0x4000];                     /* pattern rows, leftmost pixel in the top bits */
+} t_gpu_frame;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern int render_gpu;
+extern t_gpu_frame gpu_frame;
+extern void render_gpu_begin(void);
+extern const uint8 *render_lut(int index);
+#ifdef __cplusplus
+}
+#endif
+#define RENDER_GPU_BEGIN() do { if (render_gpu) render_gpu_begin(); } while (0)
+#else
+#define RENDER_GPU_BEGIN()
+#endif
 
 #endif /* _RENDER_H_ */
@@ -130,6 +130,12 @@
 /* execute main opcodes inside a big switch statement */
 #define BIG_SWITCH 1
 
+/* dispatch all opcodes through a computed goto table (GCC labels as values), */
+/* falls back to the switch statement with other compilers                    */
+#if defined(USE_Z80_THREADED) && defined(__GNUC__)
+#define Z80_THREADED 1
+#endif
+
 #define VERBOSE 0
 
 #if VERBOSE
@@ -204,22 +210,31 @@
 
 #ifdef Z80_OVERCLOCK_SHIFT
 #define USE_CYCLES(A) Z80.cycles += ((A) * z80_cycle_ratio) >> Z80_OVERCLOCK_SHIFT
-UINT32 z80_cycle_ratio;
+CONTEXT_LOCAL UINT32 z80_cycle_ratio;
 #else
 #define USE_CYCLES(A) Z80.cycles += (A)
 #endif
 
-Z80_Regs Z80;
+CONTEXT_LOCAL Z80_Regs Z80;
+
+#ifdef USE_Z80_IDLE_SKIP
+/* another address read later than this (master cycles) starts a new detection */
+#define Z80_POLL_WINDOW (256*15)
 
-unsigned char *z80_readmap[64];
-unsigned char *z80_writemap[64];
+CONTEXT_LOCAL UINT32 z80_poll_address;
+static CONTEXT_LOCAL Z80_Regs z80_poll_regs;  /* registers when z80_poll_address was read */
+static CONTEXT_LOCAL UINT32 z80_cycle_end;    /* target cycle of current z80_run call */
+#endif
+
+CONTEXT_LOCAL unsigned char *z80_readmap[64];
+CONTEXT_LOCAL unsigned char *z80_writemap[64];
 
-void (*z80_writemem)(unsigned int address, unsigned char data);
-unsigned char (*z80_readmem)(unsigned int address);
-void (*z80_writeport)(unsigned int port, unsigned char data);
-unsigned char (*z80_readport)(unsigned int port);
+CONTEXT_LOCAL void (*z80_writemem)(unsigned int address, unsigned char data);
+CONTEXT_LOCAL unsigned char (*z80_readmem)(unsigned int address);
+CONTEXT_LOCAL void (*z80_writeport)(unsigned int port, unsigned char data);
+CONTEXT_LOCAL unsigned char (*z80_readport)(unsigned int port);
 
-static UINT32 EA;
+static CONTEXT_LOCAL UINT32 EA;
 
 static UINT8 SZ[256];       /* zero and sign flags */
 static UINT8 SZ_BIT[256];   /* zero, sign and parity/overflow (=zero) flags for BIT opcode */
@@ -593,6 +608,66 @@ INLINE void BURNODD(int cycles, int opcodes, int cyclesum)
 #define EXEC_INLINE EXEC
 #endif
 
+#ifdef Z80_THREADED
+/***************************************************************
+ * expand X(prefix,opcode) for all 256 opcodes of a table
+ ***************************************************************/
+#define OPCODES(X,prefix) \
+  X(prefix,00) X(prefix,01) X(prefix,02) X(prefix,03) X(prefix,04) X(prefix,05) X(prefix,06) X(prefix,07) X(prefix,08) X(prefix,09) X(prefix,0a) X(prefix,0b) X(prefix,0c) X(prefix,0d) X(prefix,0e) X(prefix,0f) \
+  X(prefix,10) X(prefix,11) X(prefix,12) X(prefix,13) X(prefix,14) X(prefix,15) X(prefix,16) X(prefix,17) X(prefix,18) X(prefix,19) X(prefix,1a) X(prefix,1b) X(prefix,1c) X(prefix,1d) X(prefix,1e) X(prefix,1f) \
+  X(prefix,20) X(prefix,21) X(prefix,22) X(prefix,23) X(prefix,24) X(prefix,25) X(prefix,26) X(prefix,27) X(prefix,28) X(prefix,29) X(prefix,2a) X(prefix,2b) X(prefix,2c) X(prefix,2d) X(prefix,2e) X(prefix,2f) \
+  X(prefix,30) X(prefix,31) X(prefix,32) X(prefix,33) X(prefix,34) X(prefix,35) X(prefix,36) X(prefix,37) X(prefix,38) X(prefix,39) X(prefix,3a) X(prefix,3b) X(prefix,3c) X(prefix,3d) X(prefix,3e) X(prefix,3f) \
+  X(prefix,40) X(prefix,41) X(prefix,42) X(prefix,43) X(prefix,44) X(prefix,45) X(prefix,46) X(prefix,47) X(prefix,48) X(prefix,49) X(prefix,4a) X(prefix,4b) X(prefix,4c) X(prefix,4d) X(prefix,4e) X(prefix,4f) \
+  X(prefix,50) X(prefix,51) X(prefix,52) X(prefix,53) X(prefix,54) X(prefix,55) X(prefix,56) X(prefix,57) X(prefix,58) X(prefix,59) X(prefix,5a) X(prefix,5b) X(prefix,5c) X(prefix,5d) X(prefix,5e) X(prefix,5f) \
+  X(prefix,60) X(prefix,61) X(prefix,62) X(prefix,63) X(prefix,64) X(prefix,65) X(prefix,66) X(prefix,67) X(prefix,68) X(prefix,69) X(prefix,6a) X(prefix,6b) X(prefix,6c) X(prefix,6d) X(prefix,6e) X(prefix,6f) \
+  X(prefix,70) X(prefix,71) X(prefix,72) X(prefix,73) X(prefix,74) X(prefix,75) X(prefix,76) X(prefix,77) X(prefix,78) X(prefix,79) X(prefix,7a) X(prefix,7b) X(prefix,7c) X(prefix,7d) X(prefix,7e) X(prefix,7f) \
+  X(prefix,80) X(prefix,81) X(prefix,82) X(prefix,83) X(prefix,84) X(prefix,85) X(prefix,86) X(prefix,87) X(prefix,88) X(prefix,89) X(prefix,8a) X(prefix,8b) X(prefix,8c) X(prefix,8d) X(prefix,8e) X(prefix,8f) \
+  X(prefix,90) X(prefix,91) X(prefix,92) X(prefix,93) X(prefix,94) X(prefix,95) X(prefix,96) X(prefix,97) X(prefix,98) X(prefix,99) X(prefix,9a) X(prefix,9b) X(prefix,9c) X(prefix,9d) X(prefix,9e) X(prefix,9f) \
+  X(prefix,a0) X(prefix,a1) X(prefix,a2) X(prefix,a3) X(prefix,a4) X(prefix,a5) X(prefix,a6) X(prefix,a7) X(prefix,a8) X(prefix,a9) X(prefix,aa) X(prefix,ab) X(prefix,ac) X(prefix,ad) X(prefix,ae) X(prefix,af) \
+  X(prefix,b0) X(prefix,b1) X(prefix,b2) X(prefix,b3) X(prefix,b4) X(prefix,b5) X(prefix,b6) X(prefix,b7) X(prefix,b8) X(prefix,b9) X(prefix,ba) X(prefix,bb) X(prefix,bc) X(prefix,bd) X(prefix,be) X(prefix,bf) \
+  X(prefix,c0) X(prefix,c1) X(prefix,c2) X(prefix,c3) X(prefix,c4) X(prefix,c5) X(prefix,c6) X(prefix,c7) X(prefix,c8) X(prefix,c9) X(prefix,ca) X(prefix,cb) X(prefix,cc) X(prefix,cd) X(prefix,ce) X(prefix,cf) \
+  X(prefix,d0) X(prefix,d1) X(prefix,d2) X(prefix,d3) X(prefix,d4) X(prefix,d5) X(prefix,d6) X(prefix,d7) X(prefix,d8) X(prefix,d9) X(prefix,da) X(prefix,db) X(prefix,dc) X(prefix,dd) X(prefix,de) X(prefix,df) \
+  X(prefix,e0) X(prefix,e1) X(prefix,e2) X(prefix,e3) X(prefix,e4) X(prefix,e5) X(prefix,e6) X(prefix,e7) X(prefix,e8) X(prefix,e9) X(prefix,ea) X(prefix,eb) X(prefix,ec) X(prefix,ed) X(prefix,ee) X(prefix,ef) \
+  X(prefix,f0) X(prefix,f1) X(prefix,f2) X(prefix,f3) X(prefix,f4) X(prefix,f5) X(prefix,f6) X(prefix,f7) X(prefix,f8) X(prefix,f9) X(prefix,fa) X(prefix,fb) X(prefix,fc) X(prefix,fd) X(prefix,fe) X(prefix,ff)
+
+/* offsets of each opcode table in the jump table */
+#define Z80_THREAD_op   0x000
+#define Z80_THREAD_cb   0x100
+#define Z80_THREAD_dd   0x200
+#define Z80_THREAD_ed   0x300
+#define Z80_THREAD_fd   0x400
+#define Z80_THREAD_xycb 0x500
+
+#define THREAD_LABEL(prefix,opcode) &&L_##prefix##_##opcode,
+#define THREAD_OP(prefix,opcode) L_##prefix##_##opcode: prefix##_##opcode(); THREAD_NEXT;
+
+/***************************************************************
+ * jump to the code of an opcode (replaces EXEC)
+ ***************************************************************/
+#define THREAD_EXEC(prefix,opcode)                \
+{                                                 \
+  op = opcode;                                    \
+  CC(prefix,op);                                  \
+  goto *thread_table[Z80_THREAD_##prefix + op];   \
+}
+
+/***************************************************************
+ * end of an opcode: check cycles & IRQs then execute next one
+ ***************************************************************/
+#define THREAD_NEXT                               \
+{                                                 \
+  if (Z80.cycles >= cycles) goto thread_end;      \
+  if (Z80.irq_state && IFF1 && !Z80.after_ei)     \
+  {                                               \
+    take_interrupt();                             \
+    if (Z80.cycles >= cycles) goto thread_end;    \
+  }                                               \
+  Z80.after_ei = FALSE;                           \
+  R++;                                            \
+  THREAD_EXEC(op,ROP());                          \
+}
+#endif
+
 
 /***************************************************************
  * Enter HALT state; write 1 to fake port on first execution
@@ -3412,26 +3487,130 @@ void z80_reset(void)
   WZ=PCD;
 }
 
+#ifdef USE_Z80_IDLE_SKIP
+/****************************************************************************
+ * Idle loop detection (Genesis mode)
+ *
+ * Z80 RAM reads are reported here, any other memory access clears
+ * z80_poll_address. Within one z80_run call, Z80 RAM only changes through
+ * the Z80 itself, so reading the same address again with all registers but
+ * R unchanged means the Z80 is looping until an external event (68k access,
+ * interrupt), which only occurs once z80_run returns. All loop iterations
+ * ending before the target cycle are then skipped.
+ ****************************************************************************/
+void z80_poll_detect(unsigned int address)
+{
+  if (address == z80_poll_address)
+  {
+    Z80_Regs regs;
+    memcpy(&regs, &Z80, sizeof(Z80_Regs));
+    regs.r = z80_poll_regs.r;
+    regs.cycles = z80_poll_regs.cycles;
+
+    /* interrupts would be taken before next iteration */
+    if (!memcmp(&regs, &z80_poll_regs, sizeof(Z80_Regs)) && !(Z80.irq_state && IFF1) && (Z80.cycles < z80_cycle_end))
+    {
+      UINT32 period = Z80.cycles - z80_poll_regs.cycles;
+      UINT32 loops = (z80_cycle_end - 1 - Z80.cycles) / period;
+      Z80.cycles += loops * period;
+      Z80.r += loops * (UINT8)(Z80.r - z80_poll_regs.r);
+    }
+  }
+  else if ((z80_poll_address != Z80_POLL_NONE) && (Z80.cycles <= (z80_poll_regs.cycles + Z80_POLL_WINDOW)))
+  {
+    /* other address read within the same loop */
+    return;
+  }
+
+  /* restart detection from this read */
+  z80_poll_address = address;
+  memcpy(&z80_poll_regs, &Z80, sizeof(Z80_Regs));
+}
+#endif
+
 /****************************************************************************
  * Run until given cycle count 
  ****************************************************************************/
+#ifdef Z80_THREADED
+
+/* prefixed opcodes jump into the same table instead of calling Z80cb, Z80dd, ... */
+#define op_cb() { R++; THREAD_EXEC(cb,ROP()); }
+#define op_dd() { R++; THREAD_EXEC(dd,ROP()); }
+#define op_ed() { R++; THREAD_EXEC(ed,ROP()); }
+#define op_fd() { R++; THREAD_EXEC(fd,ROP()); }
+#define dd_cb() { EAX; THREAD_EXEC(xycb,ARG()); }
+#define dd_dd() THREAD_EXEC(dd,ROP())
+#define dd_fd() THREAD_EXEC(fd,ROP())
+#define fd_cb() { EAY; THREAD_EXEC(xycb,ARG()); }
+#define fd_dd() THREAD_EXEC(dd,ROP())
+#define fd_fd() THREAD_EXEC(fd,ROP())
+
 void z80_run(unsigned int cycles)
 {
+  static const void *const thread_table[0x600] =
+  {
+    OPCODES(THREAD_LABEL,op)
+    OPCODES(THREAD_LABEL,cb)
+    OPCODES(THREAD_LABEL,dd)
+    OPCODES(THREAD_LABEL,ed)
+    OPCODES(THREAD_LABEL,fd)
+    OPCODES(THREAD_LABEL,xycb)
+  };
+  unsigned op;
+
+  PROFILER_ENTER(PROFILER_Z80);
+
+#ifdef USE_Z80_IDLE_SKIP
+  /* Z80 RAM may have been modified since last call */
+  z80_poll_address = Z80_POLL_NONE;
+  z80_cycle_end = cycles;
+#endif
+
+  /* check for IRQs before each instruction */
+  THREAD_NEXT;
+
+  OPCODES(THREAD_OP,op)
+  OPCODES(THREAD_OP,cb)
+  OPCODES(THREAD_OP,dd)
+  OPCODES(THREAD_OP,ed)
+  OPCODES(THREAD_OP,fd)
+  OPCODES(THREAD_OP,xycb)
+
+thread_end:
+  PROFILER_LEAVE();
+}
+
+#else
+
+void z80_run(unsigned int cycles)
+{
+  PROFILER_ENTER(PROFILER_Z80);
+
+#ifdef USE_Z80_IDLE_SKIP
+  /* Z80 RAM may have been modified since last call */
+  z80_poll_address = Z80_POLL_NONE;
+  z80_cycle_end = cycles;
+#endif
+
   while( Z80.cycles < cycles )
   {
     /* check for IRQs before each instruction */
     if (Z80.irq_state && IFF1 && !Z80.after_ei)
     {
       take_interrupt();
-      if (Z80.cycles >= cycles) return;
+      if (Z80.cycles >= cycles) break;
     }
 
     Z80.after_ei = FALSE;
     R++;
     EXEC_INLINE(op,ROP());
   }
+
+  PROFILER_LEAVE();
 } 
 
+#endif
+
 /****************************************************************************
  * Get all registers in given buffer
  ****************************************************************************/
@@ -3477,3 +3656,27 @@ void z80_set_nmi_line(unsigned int state)
   Z80.nmi_state = state;
 }
 
+
+#ifdef USE_CORE_CONTEXT
+void z80_context_regions(void)
+{
+#ifdef Z80_OVERCLOCK_SHIFT
+  CONTEXT_REGION(z80_cycle_ratio);
+#endif
+  CONTEXT_REGION(Z80);
+#ifdef USE_Z80_IDLE_SKIP
+  CONTEXT_REGION(z80_poll_address);
+  CONTEXT_REGION(z80_poll_regs);
+  CONTEXT_REGION(z80_cycle_end);
+#endif
+  CONTEXT_REGION(z80_readmap);
+  CONTEXT_REGION(z80_writemap);
+  CONTEXT_POINTERS(z80_readmap[0], 64, sizeof(z80_readmap[0]));
+  CONTEXT_POINTERS(z80_writemap[0], 64, sizeof(z80_writemap[0]));
+  CONTEXT_REGION(z80_writemem);
+  CONTEXT_REGION(z80_readmem);
+  CONTEXT_REGION(z80_writeport);
+  CONTEXT_REGION(z80_readport);
+  CONTEXT_REGION(EA);
+}
+#endif
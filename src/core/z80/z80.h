@@ -49,19 +49,26 @@ typedef struct
 }  Z80_Regs;
 
 
-extern Z80_Regs Z80;
+extern CONTEXT_LOCAL Z80_Regs Z80;
 
 #ifdef Z80_OVERCLOCK_SHIFT
-extern UINT32 z80_cycle_ratio;
+extern CONTEXT_LOCAL UINT32 z80_cycle_ratio;
 #endif
 
-extern unsigned char *z80_readmap[64];
-extern unsigned char *z80_writemap[64];
+extern CONTEXT_LOCAL unsigned char *z80_readmap[64];
+extern CONTEXT_LOCAL unsigned char *z80_writemap[64];
 
-extern void (*z80_writemem)(unsigned int address, unsigned char data);
-extern unsigned char (*z80_readmem)(unsigned int address);
-extern void (*z80_writeport)(unsigned int port, unsigned char data);
-extern unsigned char (*z80_readport)(unsigned int port);
+extern CONTEXT_LOCAL void (*z80_writemem)(unsigned int address, unsigned char data);
+extern CONTEXT_LOCAL unsigned char (*z80_readmem)(unsigned int address);
+extern CONTEXT_LOCAL void (*z80_writeport)(unsigned int port, unsigned char data);
+extern CONTEXT_LOCAL unsigned char (*z80_readport)(unsigned int port);
+
+#ifdef USE_Z80_IDLE_SKIP
+/* Z80 RAM address read first in a possible idle loop (Z80_POLL_NONE if none) */
+#define Z80_POLL_NONE 0xFFFFFFFF
+extern CONTEXT_LOCAL UINT32 z80_poll_address;
+extern void z80_poll_detect(unsigned int address);
+#endif
 
 extern void z80_init(const void *config, int (*irqcallback)(int));
 extern void z80_reset (void);
@@ -0,0 +1,68 @@
+#include <atomic>
+
+#include "framemailbox.h"
+
+/* Mailbox state: index of the middle buffer, plus a flag set while it */
+/* holds a frame the presentation thread has not picked up yet */
+#define MAILBOX_INDEX 0x03
+#define MAILBOX_FRESH 0x04
+
+static uint8 *mailbox_buffers[3];
+static std::atomic<int> mailbox_state;
+
+/* Only ever touched by their own thread */
+static int mailbox_back;
+static int mailbox_front;
+
+int framemailbox_init(int size) {
+  for (int i = 0; i < 3; i++) {
+    mailbox_buffers[i] = (uint8 *)calloc(1, size);
+    if (mailbox_buffers[i] == NULL) {
+      framemailbox_close();
+      return 0;
+    }
+  }
+
+  mailbox_back = 0;
+  mailbox_state.store(1);
+  mailbox_front = 2;
+  return 1;
+}
+
+void framemailbox_close(void) {
+  for (int i = 0; i < 3; i++) {
+    free(mailbox_buffers[i]);
+    mailbox_buffers[i] = NULL;
+  }
+}
+
+uint8 *framemailbox_back(void) {
+  return mailbox_buffers[mailbox_back];
+}
+
+uint8 *framemailbox_publish(void) {
+  /* Swap the finished frame with the middle buffer and flag it as new */
+  int state = mailbox_state.exchange(
+    mailbox_back | MAILBOX_FRESH,
+    std::memory_order_acq_rel
+  );
+  mailbox_back = state & MAILBOX_INDEX;
+  return mailbox_buffers[mailbox_back];
+}
+
+int framemailbox_acquire(void) {
+  if (!(mailbox_state.load(std::memory_order_acquire) & MAILBOX_FRESH))
+    return 0;
+
+  /* Swap the middle buffer with the one we were displaying */
+  int state = mailbox_state.exchange(
+    mailbox_front,
+    std::memory_order_acq_rel
+  );
+  mailbox_front = state & MAILBOX_INDEX;
+  return 1;
+}
+
+uint8 *framemailbox_front(void) {
+  return mailbox_buffers[mailbox_front];
+}
@@ -0,0 +1,40 @@
+#ifndef _FRAMEMAILBOX_H_
+#define _FRAMEMAILBOX_H_
+
+#include "shared.h"
+
+/****************************************************************************
+ * Triple-buffered frame mailbox
+ *
+ * Hands finished frames from the emulation thread to the presentation
+ * thread without locking. The emulation thread always renders into the
+ * "back" buffer and publishes it, the presentation thread always reads the
+ * "front" buffer, and the buffer in between holds the newest frame that
+ * has not been picked up yet. Neither side ever waits for the other:
+ * frames that are not picked up in time are simply replaced.
+ *
+ ****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Allocate the three frame buffers (size in bytes) */
+extern int framemailbox_init(int size);
+extern void framemailbox_close(void);
+
+/* Emulation side: buffer to render into, and publish it once complete */
+/* (returns the buffer to render the next frame into) */
+extern uint8 *framemailbox_back(void);
+extern uint8 *framemailbox_publish(void);
+
+/* Presentation side: pick up the newest published frame, if any */
+/* (returns 0 when no new frame was published since the last call) */
+extern int framemailbox_acquire(void);
+extern uint8 *framemailbox_front(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRAMEMAILBOX_H_ */
@@ -138,6 +138,8 @@ void gamehacks_update_sound() {
     work_ram[mQueue_0] = gamehacks_play_sound(work_ram[mQueue_0]);
     work_ram[mQueue_1] = gamehacks_play_sound(work_ram[mQueue_1]);
     work_ram[mQueue_2] = gamehacks_play_sound(work_ram[mQueue_2]);
+    STATE_DIRTY_PTR(&work_ram[mQueue_0]);
+    STATE_DIRTY_PTR(&work_ram[mQueue_2]);
 
     Backend_Sound_MusicSpeed(
         (work_ram[mFlags] & mFlags_Mask_SpeedShoes) ?
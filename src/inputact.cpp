@@ -10,14 +10,25 @@
 uint16 pad_action[MAX_DEVICES];
 uint16 pad_analog[MAX_DEVICES];
 
+// Pad states as last updated, copied to input.pad once per frame: in threaded
+// mode the emulation thread must never see a pad halfway through an update
+static std::atomic<uint16> pad_state[MAX_DEVICES];
+
 void input_update_pad(int padnum) {
-    input.pad[padnum] = pad_action[padnum] | pad_analog[padnum];
+    uint16 pad = pad_action[padnum] | pad_analog[padnum];
     if (option_mirrormode) {
-        bool left = input.pad[padnum] & INPUT_LEFT;
-        bool right = input.pad[padnum] & INPUT_RIGHT;
-        input.pad[padnum] &= ~(INPUT_RIGHT | INPUT_LEFT);
-        if (left) input.pad[padnum] |= INPUT_RIGHT;
-        if (right) input.pad[padnum] |= INPUT_LEFT;
+        bool left = pad & INPUT_LEFT;
+        bool right = pad & INPUT_RIGHT;
+        pad &= ~(INPUT_RIGHT | INPUT_LEFT);
+        if (left) pad |= INPUT_RIGHT;
+        if (right) pad |= INPUT_LEFT;
+    }
+    pad_state[padnum].store(pad);
+}
+
+void input_sync_pads() {
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        input.pad[i] = pad_state[i].load();
     }
 }
 
@@ -71,7 +82,11 @@ void input_run_action(char *str, int press) {
                 if (quit_result != pfd::button::yes) return;
             }
         #endif
-        system_reset();
+        // Handled by the emulation loop before its next frame
+        reset_pending = 1;
+    } else if (strcmp(str, "rewind") == 0) {
+        // Steps back one frame per frame for as long as it is held
+        rewind_pending = press;
     } else if (strcmp(str, "fullscreen") == 0) {
         if (press) Backend_Video_ToggleFullscreen();
     } else if (strcmp(str, "quit") == 0) {
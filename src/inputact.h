@@ -12,12 +12,19 @@ int input_process_keycode(char *keystr, int press);
 void inputact_init();
 void input_process_joystick(int joynum, int button, int press);
 void input_update_pad(int padnum);
+void input_sync_pads();
 
 extern uint16 pad_action[MAX_DEVICES];
 extern uint16 pad_analog[MAX_DEVICES];
 
 #ifdef __cplusplus
 }
+
+#include <atomic>
+
+/* Set from input actions, handled by the emulation loop before its next frame */
+extern std::atomic<int> reset_pending;
+extern std::atomic<int> rewind_pending;
 #endif
 
 #endif
\ No newline at end of file
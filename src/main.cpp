@@ -1,5 +1,10 @@
 #include <time.h>
 #include <errno.h>
+#include <atomic>
+
+#ifndef __EMSCRIPTEN__
+  #include <thread>
+#endif
 
 #include <sys/stat.h>
 #include <limits.h>
@@ -39,10 +44,16 @@ short soundframe[SOUND_SAMPLES_SIZE];
 #include "backends/video/video_base.h"
 int option_mirrormode = 0;
 int option_scaling = 0;
+unsigned char *video_frame;
+int video_dirty[VIDEO_DIRTY_MAX][2];
+int video_dirty_count = -1;
 
 #include "backends/input/input_base.h"
 
 #include "gamehacks.h"
+#include "framemailbox.h"
+#include "rewind.h"
+#include "renderpool.h"
 
 #define STATIC_ASSERT(name, test) typedef struct { int assert_[(test)?1:-1]; } assert_ ## name ## _
 #define M68K_MAX_CYCLES 1107
@@ -77,6 +88,8 @@ int log_error   = 0;
 int debug_on    = 0;
 int turbo_mode  = 0;
 int use_sound   = 1;
+std::atomic<int> reset_pending(0);
+std::atomic<int> rewind_pending(0);
 
 static uint8 brm_format[0x40] =
 {
@@ -126,8 +139,23 @@ static void update_overclock(void)
 
 int running = 1;
 
-void mainloop() {
-  Backend_Input_MainLoop();
+/* "running" is cleared by the input & video backends on the main thread, */
+/* the emulation loop stops on this copy of it instead                    */
+static std::atomic<int> emulation_running(1);
+
+void emulate_frame() {
+  if (reset_pending.exchange(0)) {
+    system_reset();
+  }
+
+  input_sync_pads();
+
+  /* While rewind is held, each frame replays the one before it */
+  PROFILER_ENTER(PROFILER_REWIND);
+  if (rewind_pending) rewind_pop();
+  else rewind_push();
+  PROFILER_LEAVE();
+
   gamehacks_update();
 
   #ifdef HAVE_OVERCLOCK
@@ -135,18 +163,188 @@ void mainloop() {
     if (overclock_delay && --overclock_delay == 0)
         update_overclock();
   #endif
-  Backend_Video_Clear();
-  gamehacks_render();
+}
 
+void run_frame() {
   if (system_hw == SYSTEM_MCD) system_frame_scd(0);
   else if ((system_hw & SYSTEM_PBC) == SYSTEM_MD) system_frame_gen(0);
   else system_frame_sms(0);
+}
+
+/* Audio-synced pacing: the fill level of the backend's audio queue steers   */
+/* how many samples each frame produces, by nudging the framerate given to   */
+/* audio_set_rate() by at most AUDIO_SYNC_MAX_DEVIATION (well below audible  */
+/* pitch change). The queue is kept half full, so it neither runs dry nor    */
+/* overflows; when it is full anyway, emulation waits for the device to      */
+/* catch up instead of the backend dropping the chunk.                       */
+#define AUDIO_SYNC_MAX_DEVIATION  0.005
+#define AUDIO_SYNC_SMOOTHING      16
+
+int audio_sync = 0;
+static double audio_sync_fill = -1;
+static double audio_sync_ratio = 1.0;
+
+void audio_sync_wait() {
+  timespec idleSpec = { .tv_sec = 0, .tv_nsec = 1000000L };
+  int capacity = 0;
+  int queued = Backend_Sound_GetQueued(&capacity);
+
+  PROFILER_ENTER(PROFILER_IDLE);
+  while (emulation_running && !turbo_mode && (capacity > 0) && (queued >= capacity)) {
+    nanosleep(&idleSpec, NULL);
+    queued = Backend_Sound_GetQueued(&capacity);
+  }
+  PROFILER_LEAVE();
+}
+
+void audio_sync_update() {
+  int capacity = 0;
+  int queued = Backend_Sound_GetQueued(&capacity);
+  if ((queued < 0) || (capacity <= 0)) return;
+
+  /* Queue level only moves in device buffer sized steps, so smooth it */
+  if (audio_sync_fill < 0) audio_sync_fill = queued;
+  audio_sync_fill += (queued - audio_sync_fill) / AUDIO_SYNC_SMOOTHING;
+
+  double target = capacity / 2.0;
+  double error = (audio_sync_fill - target) / target;
+  if (error > 1.0) error = 1.0;
+  else if (error < -1.0) error = -1.0;
+
+  /* Fuller queue = higher framerate = fewer samples per frame */
+  double ratio = 1.0 + (error * AUDIO_SYNC_MAX_DEVIATION);
+  double delta = ratio - audio_sync_ratio;
+  if ((delta < 0.0001) && (delta > -0.0001)) return;
+  audio_sync_ratio = ratio;
+
+  double framerate = (double)system_clock / (MCYCLES_PER_LINE * (vdp_pal ? 313 : 262));
+  audio_set_rate(SOUND_FREQUENCY, framerate * ratio);
+}
+
+void mainloop_sound() {
+  int sound_update_size = audio_update(soundframe) * 2;
+  if (!use_sound || rewind_pending) return;
+
+  if (audio_sync) audio_sync_wait();
+
+  PROFILER_ENTER(PROFILER_SOUND_BACKEND);
+  Backend_Sound_Update(sound_update_size);
+  PROFILER_LEAVE();
+
+  if (audio_sync) audio_sync_update();
+}
+
+void mainloop() {
+  Backend_Input_MainLoop();
+  emulate_frame();
+
+  PROFILER_ENTER(PROFILER_VIDEO_BACKEND);
+  Backend_Video_Clear();
+  gamehacks_render();
+  PROFILER_LEAVE();
+
+  run_frame();
 
+  PROFILER_ENTER(PROFILER_VIDEO_BACKEND);
+  video_frame = bitmap.data;
+#ifdef USE_DIRTY_LINES
+  video_dirty_count = render_dirty_runs(video_dirty, VIDEO_DIRTY_MAX);
+#endif
   Backend_Video_Update();
   Backend_Video_Present();
-  int sound_update_size = audio_update(soundframe) * 2;
-  if (use_sound) Backend_Sound_Update(sound_update_size);
+  PROFILER_LEAVE();
+
+  mainloop_sound();
+
+  #ifdef ENABLE_PROFILER
+    profiler_frame();
+  #endif
+}
+
+#ifndef __EMSCRIPTEN__
+long updatePeriod_nsec = (1000000000.0L / FRAMERATE_TARGET);
+
+void mainloop_wait(timespec *timeBefore) {
+  PROFILER_ENTER(PROFILER_IDLE);
+
+  timespec timeAfter;
+  clock_gettime(CLOCK_MONOTONIC, &timeAfter);
+
+  timespec deltaSpec = {
+    .tv_sec = timeAfter.tv_sec - timeBefore->tv_sec,
+    .tv_nsec = timeAfter.tv_nsec - timeBefore->tv_nsec
+  };
+
+  if (deltaSpec.tv_nsec < 0) {
+      --deltaSpec.tv_sec;
+      deltaSpec.tv_nsec += 1000000000L;
+  }
+
+  if (!turbo_mode && ((updatePeriod_nsec - deltaSpec.tv_nsec) > 0)) {
+    deltaSpec.tv_nsec = updatePeriod_nsec - deltaSpec.tv_nsec;
+
+    while ( nanosleep(&deltaSpec, &deltaSpec) == EINTR ) {
+      /* Keep running "nanosleep" in case interrupt signal was received */;
+    }
+  }
+
+  PROFILER_LEAVE();
+}
+
+/* Threaded mode: emulation runs on its own thread, paced by the frame timer,  */
+/* and publishes each finished frame to the mailbox. The main thread handles   */
+/* input and presents the newest frame, so a present blocking on vsync never   */
+/* delays emulation. Viewport fields are still read straight from "bitmap":    */
+/* they only change on video mode switches. Only the emulation thread is      */
+/* profiled, so the video backend shows up in no profiler section.            */
+void mainloop_emulation_thread() {
+  timespec timeBefore;
+
+  bitmap.data = framemailbox_back();
+
+  while(emulation_running) {
+    clock_gettime(CLOCK_MONOTONIC, &timeBefore);
+
+    emulate_frame();
+    run_frame();
+    bitmap.data = framemailbox_publish();
+
+    mainloop_sound();
+
+    #ifdef ENABLE_PROFILER
+      profiler_frame();
+    #endif
+
+    mainloop_wait(&timeBefore);
+  }
+}
+
+void mainloop_threaded() {
+  std::thread emulation_thread(mainloop_emulation_thread);
+
+  timespec idleSpec = { .tv_sec = 0, .tv_nsec = 1000000L };
+
+  while(running) {
+    Backend_Input_MainLoop();
+
+    if (!framemailbox_acquire()) {
+      /* Nothing new to show yet */
+      nanosleep(&idleSpec, NULL);
+      continue;
+    }
+
+    Backend_Video_Clear();
+    gamehacks_render();
+
+    video_frame = framemailbox_front();
+    Backend_Video_Update();
+    Backend_Video_Present();
+  }
+
+  emulation_running = 0;
+  emulation_thread.join();
 }
+#endif
 
 char *get_valid_filepath_jsonarray(json_t *patharr) {
   if (patharr == NULL) return NULL;
@@ -296,7 +494,7 @@ int main (int argc, char *argv[]) {
 
   /* initialize Genesis virtual system */
   memset(&bitmap, 0, sizeof(t_bitmap));
-  bitmap.width        = 400;
+  bitmap.width        = VIDEO_WIDTH;
   bitmap.height       = 224;
 #if defined(USE_8BPP_RENDERING)
   bitmap.pitch        = (bitmap.width * 1);
@@ -394,37 +592,57 @@ int main (int argc, char *argv[]) {
 
   //if (use_sound) Backend_Sound_Pause();
 
-  long updatePeriod_nsec = (1000000000.0L / FRAMERATE_TARGET);
-
   gamehacks_init();
 
+  json_t *config_rewind = json_object_get(json_object_get(config_json, "system"), "rewind_mb");
+  if ((config_rewind != NULL) && (json_integer_value(config_rewind) > 0))
+  {
+    /* At most 1 GB, so the size in bytes fits rewind_init */
+    json_int_t rewind_mb = json_integer_value(config_rewind);
+    rewind_init((int)((rewind_mb < 1024 ? rewind_mb : 1024) << 20));
+  }
+
+  #ifdef USE_PARALLEL_RENDER
+    json_t *config_render_threads = json_object_get(json_object_get(config_json, "system"), "render_threads");
+    if (config_render_threads != NULL)
+      render_pool_init(json_integer_value(config_render_threads));
+  #endif
+
+  #ifdef ENABLE_PROFILER
+    profiler_reset();
+  #endif
+
   /* emulation loop */
   #ifdef __EMSCRIPTEN__
    emscripten_set_main_loop(&mainloop, 60, 1);
   #else
-    timespec timeAfter, timeBefore;
+    json_t *config_system = json_object_get(config_json, "system");
+    json_t *config_threaded = json_object_get(config_system, "threaded");
+    json_t *config_audio_sync = json_object_get(config_system, "audio_sync");
 
-    while(running) {
-      clock_gettime(CLOCK_MONOTONIC, &timeBefore);
-      mainloop();
-      clock_gettime(CLOCK_MONOTONIC, &timeAfter);
+    audio_sync = (config_audio_sync != NULL) && json_boolean_value(config_audio_sync);
 
-      timespec deltaSpec = {
-        .tv_sec = timeAfter.tv_sec - timeBefore.tv_sec,
-        .tv_nsec = timeAfter.tv_nsec - timeBefore.tv_nsec
-      };
-
-      if (deltaSpec.tv_nsec < 0) {
-          --deltaSpec.tv_sec;
-          deltaSpec.tv_nsec += 1000000000L;
-      }
-
-      if (!turbo_mode && ((updatePeriod_nsec - deltaSpec.tv_nsec) > 0)) {
-        deltaSpec.tv_nsec = updatePeriod_nsec - deltaSpec.tv_nsec;
-
-        while ( nanosleep(&deltaSpec, &deltaSpec) == EINTR ) {
-          /* Keep running "nanosleep" in case interrupt signal was received */;
-        }
+    if (
+      (config_threaded != NULL) &&
+      json_boolean_value(config_threaded) &&
+      framemailbox_init(bitmap.pitch * ((VIDEO_HEIGHT * 2) + 1))
+    ) {
+      unsigned char *backend_data = bitmap.data;
+      #ifdef USE_GPU_RENDER
+        /* Captured lines are only valid until the next frame starts, */
+        /* so threaded frames are all drawn by the CPU                */
+        render_gpu = 0;
+      #endif
+      mainloop_threaded();
+      framemailbox_close();
+      bitmap.data = backend_data;
+    } else {
+      timespec timeBefore;
+
+      while(running) {
+        clock_gettime(CLOCK_MONOTONIC, &timeBefore);
+        mainloop();
+        mainloop_wait(&timeBefore);
       }
     }
 
@@ -468,6 +686,15 @@ int main (int argc, char *argv[]) {
     }
 
     gamehacks_deinit();
+    rewind_close();
+
+    #ifdef USE_PARALLEL_RENDER
+      render_pool_close();
+    #endif
+
+    #ifdef ENABLE_PROFILER
+      profiler_dump_csv("./profile.csv");
+    #endif
 
     audio_shutdown();
     error_shutdown();
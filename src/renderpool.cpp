@@ -0,0 +1,114 @@
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
+
+#include "renderpool.h"
+
+#ifdef USE_PARALLEL_RENDER
+
+static std::vector<std::thread> render_pool_workers;
+static std::mutex render_pool_mutex;
+static std::condition_variable render_pool_start;
+static std::condition_variable render_pool_done;
+static unsigned int render_pool_generation;
+static bool render_pool_exit;
+
+/* Job of the current run, handed out from index 1 */
+/* (next is parked past any count between runs, for workers that wake late) */
+#define RENDER_POOL_CLOSED 0x40000000
+static void (*render_pool_job)(int index);
+static int render_pool_count;
+static std::atomic<int> render_pool_next;
+static std::atomic<int> render_pool_pending;
+
+static void render_pool_work(void) {
+  int next;
+
+  while ((next = render_pool_next.fetch_add(1)) < render_pool_count) {
+    render_pool_job(next);
+
+    if (render_pool_pending.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(render_pool_mutex);
+      render_pool_done.notify_one();
+    }
+  }
+}
+
+static void render_pool_worker(void) {
+  unsigned int generation = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(render_pool_mutex);
+      render_pool_start.wait(lock, [&] { return render_pool_exit || (render_pool_generation != generation); });
+      if (render_pool_exit) return;
+      generation = render_pool_generation;
+    }
+
+    render_pool_work();
+  }
+}
+
+int render_pool_init(int threads) {
+  if (threads <= 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  render_pool_generation = 0;
+  render_pool_exit = false;
+  render_pool_count = 0;
+  render_pool_next.store(RENDER_POOL_CLOSED);
+  render_pool_pending.store(0);
+
+  /* the calling thread renders the first band */
+  for (int i = 1; i < threads; i++)
+    render_pool_workers.emplace_back(render_pool_worker);
+
+  return threads;
+}
+
+void render_pool_close(void) {
+  {
+    std::lock_guard<std::mutex> lock(render_pool_mutex);
+    render_pool_exit = true;
+  }
+  render_pool_start.notify_all();
+
+  for (auto &worker : render_pool_workers)
+    worker.join();
+  render_pool_workers.clear();
+}
+
+int render_pool_threads(void) {
+  return (int)render_pool_workers.size() + 1;
+}
+
+void render_pool_run(void (*job)(int index), int count) {
+  if (count > 1) {
+    render_pool_job = job;
+    render_pool_count = count;
+
+    /* pending must be set before any worker can grab a job */
+    render_pool_pending.store(count - 1);
+    render_pool_next.store(1);
+
+    {
+      std::lock_guard<std::mutex> lock(render_pool_mutex);
+      render_pool_generation++;
+    }
+    render_pool_start.notify_all();
+  }
+
+  /* the caller keeps to its own band, its thread-local state belongs to the frame */
+  job(0);
+
+  if (count > 1) {
+    std::unique_lock<std::mutex> lock(render_pool_mutex);
+    render_pool_done.wait(lock, [] { return render_pool_pending.load() == 0; });
+    render_pool_next.store(RENDER_POOL_CLOSED);
+  }
+}
+
+#endif /* USE_PARALLEL_RENDER */
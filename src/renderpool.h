@@ -0,0 +1,43 @@
+#ifndef _RENDERPOOL_H_
+#define _RENDERPOOL_H_
+
+#include "shared.h"
+
+/****************************************************************************
+ * Scanline render thread pool (PARALLEL_RENDER=1 builds)
+ *
+ * Lets the renderer split the lines queued during a frame into bands and
+ * render them at the same time. The thread asking for the work always takes
+ * the first band itself and nothing else, so its own line buffers and sprite
+ * lists keep following the frame; the other bands go to the pool threads,
+ * which each have their own (see RENDER_LOCAL in vdp_render.c).
+ *
+ * Without render_pool_init, or with a single thread, everything runs on
+ * the calling thread as before.
+ *
+ ****************************************************************************/
+
+#ifdef USE_PARALLEL_RENDER
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Start the pool (threads <= 0 means one per CPU core, the caller included) */
+extern int render_pool_init(int threads);
+extern void render_pool_close(void);
+
+/* Number of threads rendering at once, the caller included */
+extern int render_pool_threads(void);
+
+/* Run job(0) on the calling thread and job(1) .. job(count - 1) on the pool */
+/* (returns once all of them are done) */
+extern void render_pool_run(void (*job)(int index), int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USE_PARALLEL_RENDER */
+
+#endif /* _RENDERPOOL_H_ */
@@ -0,0 +1,223 @@
+#include <zlib.h>
+
+#include "rewind.h"
+
+/* Deltas are mostly long runs of zeros: fastest level, run-length matching */
+#define REWIND_LEVEL    1
+#define REWIND_STRATEGY Z_RLE
+
+/* Smallest compressed delta expected, used to size the entry ring */
+#define REWIND_MIN_ENTRY 64
+
+typedef struct {
+  int offset;   /* position of the compressed delta in the arena */
+  int packed;   /* compressed length */
+  int length;   /* uncompressed length */
+  int size;     /* size of the state it restores */
+} t_rewind_entry;
+
+static uint8 *rewind_arena;
+static int rewind_arena_size;
+static int rewind_write;
+
+/* Ring of deltas, oldest first */
+static t_rewind_entry *rewind_entries;
+static int rewind_capacity;
+static int rewind_first;
+static int rewind_count;
+
+/* Newest state (rewind_head_size is 0 until one is recorded), plus a scratch */
+/* buffer. Both are kept zeroed past the state they hold, so states of        */
+/* different sizes XOR cleanly */
+static uint8 *rewind_head;
+static int rewind_head_size;
+static uint8 *rewind_scratch;
+
+static uint8 *rewind_packed;
+static int rewind_packed_size;
+
+static z_stream rewind_deflate;
+static z_stream rewind_inflate;
+static int rewind_streams;
+
+static void rewind_xor(uint8 *dst, const uint8 *src, int length) {
+  uint32 *d = (uint32 *)dst;
+  const uint32 *s = (const uint32 *)src;
+  int i;
+
+  /* buffers are STATE_SIZE bytes, a multiple of 4 */
+  for (i = 0; i < (length + 3) >> 2; i++)
+    d[i] ^= s[i];
+}
+
+static t_rewind_entry *rewind_entry(int index) {
+  return &rewind_entries[(rewind_first + index) % rewind_capacity];
+}
+
+static void rewind_drop_oldest(void) {
+  rewind_first = (rewind_first + 1) % rewind_capacity;
+  rewind_count--;
+}
+
+/* Make room for a delta of the given length at the write position */
+static int rewind_reserve(int packed) {
+  if (packed > rewind_arena_size) return 0;
+
+  if (packed > (rewind_arena_size - rewind_write)) {
+    /* the deltas after the write position are the oldest ones */
+    while (rewind_count && (rewind_entry(0)->offset >= rewind_write))
+      rewind_drop_oldest();
+    rewind_write = 0;
+  }
+
+  while (rewind_count) {
+    t_rewind_entry *oldest = rewind_entry(0);
+    if ((rewind_count < rewind_capacity) &&
+        ((oldest->offset >= (rewind_write + packed)) || ((oldest->offset + oldest->packed) <= rewind_write)))
+      break;
+    rewind_drop_oldest();
+  }
+
+  return 1;
+}
+
+int rewind_init(int size) {
+  rewind_arena_size = size;
+  rewind_capacity = size / REWIND_MIN_ENTRY;
+  rewind_packed_size = compressBound(STATE_SIZE);
+
+  rewind_arena = (uint8 *)malloc(size);
+  rewind_entries = (t_rewind_entry *)malloc(rewind_capacity * sizeof(t_rewind_entry));
+  rewind_head = (uint8 *)calloc(1, STATE_SIZE);
+  rewind_scratch = (uint8 *)calloc(1, STATE_SIZE);
+
+  memset(&rewind_deflate, 0, sizeof(z_stream));
+  memset(&rewind_inflate, 0, sizeof(z_stream));
+  rewind_streams = (deflateInit2(&rewind_deflate, REWIND_LEVEL, Z_DEFLATED, -MAX_WBITS, 8, REWIND_STRATEGY) == Z_OK) &&
+                   (inflateInit2(&rewind_inflate, -MAX_WBITS) == Z_OK);
+  rewind_packed = (uint8 *)malloc(rewind_packed_size);
+
+  if (!rewind_arena || !rewind_entries || !rewind_head || !rewind_scratch || !rewind_packed || !rewind_streams || !rewind_capacity) {
+    rewind_close();
+    return 0;
+  }
+
+  /* commit the arena now rather than page by page while recording */
+  memset(rewind_arena, 0, size);
+
+  rewind_reset();
+  return 1;
+}
+
+void rewind_close(void) {
+  if (rewind_streams) {
+    deflateEnd(&rewind_deflate);
+    inflateEnd(&rewind_inflate);
+    rewind_streams = 0;
+  }
+
+  free(rewind_arena);
+  free(rewind_entries);
+  free(rewind_head);
+  free(rewind_scratch);
+  free(rewind_packed);
+  rewind_arena = NULL;
+  rewind_entries = NULL;
+  rewind_head = NULL;
+  rewind_scratch = NULL;
+  rewind_packed = NULL;
+}
+
+void rewind_reset(void) {
+  if (!rewind_arena) return;
+
+  rewind_write = 0;
+  rewind_first = 0;
+  rewind_count = 0;
+  rewind_head_size = 0;
+  memset(rewind_head, 0, STATE_SIZE);
+}
+
+void rewind_push(void) {
+  uint8 *state;
+  int size, length;
+
+  if (!rewind_arena) return;
+
+  size = state_save(rewind_scratch);
+
+  if (!rewind_head_size) {
+    state = rewind_head;
+    rewind_head = rewind_scratch;
+    rewind_scratch = state;
+    rewind_head_size = size;
+    return;
+  }
+
+  /* turn the previous state into the delta leading back to it */
+  length = (size > rewind_head_size) ? size : rewind_head_size;
+  rewind_xor(rewind_head, rewind_scratch, length);
+
+  deflateReset(&rewind_deflate);
+  rewind_deflate.next_in = rewind_head;
+  rewind_deflate.avail_in = length;
+  rewind_deflate.next_out = rewind_packed;
+  rewind_deflate.avail_out = rewind_packed_size;
+
+  if ((deflate(&rewind_deflate, Z_FINISH) == Z_STREAM_END) && rewind_reserve(rewind_deflate.total_out)) {
+    t_rewind_entry *entry = &rewind_entries[(rewind_first + rewind_count) % rewind_capacity];
+    entry->offset = rewind_write;
+    entry->packed = rewind_deflate.total_out;
+    entry->length = length;
+    entry->size = rewind_head_size;
+    memcpy(rewind_arena + rewind_write, rewind_packed, entry->packed);
+    rewind_write += entry->packed;
+    rewind_count++;
+  } else {
+    /* history can't be chained to this state anymore */
+    rewind_write = 0;
+    rewind_first = 0;
+    rewind_count = 0;
+  }
+
+  /* new state becomes the head, old buffer is cleared for the next one */
+  memset(rewind_head, 0, length);
+  state = rewind_head;
+  rewind_head = rewind_scratch;
+  rewind_scratch = state;
+  rewind_head_size = size;
+}
+
+int rewind_pop(void) {
+  t_rewind_entry *entry;
+
+  if (!rewind_arena || !rewind_head_size) return 0;
+
+  state_load(rewind_head);
+
+  /* oldest state stays, so holding rewind pauses on it */
+  if (!rewind_count) return 1;
+
+  entry = rewind_entry(rewind_count - 1);
+
+  inflateReset(&rewind_inflate);
+  rewind_inflate.next_in = rewind_arena + entry->offset;
+  rewind_inflate.avail_in = entry->packed;
+  rewind_inflate.next_out = rewind_scratch;
+  rewind_inflate.avail_out = STATE_SIZE;
+
+  if (inflate(&rewind_inflate, Z_FINISH) != Z_STREAM_END) {
+    rewind_count = 0;
+    memset(rewind_scratch, 0, STATE_SIZE);
+    return 1;
+  }
+
+  rewind_xor(rewind_head, rewind_scratch, entry->length);
+  memset(rewind_scratch, 0, entry->length);
+  rewind_head_size = entry->size;
+
+  /* space of the newest delta is reused by the next push */
+  rewind_write = entry->offset;
+  rewind_count--;
+  return 1;
+}
@@ -0,0 +1,41 @@
+#ifndef _REWIND_H_
+#define _REWIND_H_
+
+#include "shared.h"
+
+/****************************************************************************
+ * Rewind buffer
+ *
+ * Records the machine state at the start of every frame into a ring that
+ * lives in one fixed-size arena. Only the newest state is kept as is: each
+ * older one is stored as the XOR against the state that followed it, which
+ * is mostly zeros and deflates to a few KB. Stepping back XORs the newest
+ * delta into the newest state, so going back N frames costs N small
+ * inflates and nothing is ever allocated after rewind_init. When the arena
+ * is full, the oldest frames are dropped.
+ *
+ ****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Allocate the arena (size in bytes) and compression state */
+extern int rewind_init(int size);
+extern void rewind_close(void);
+
+/* Record the current state (call once per frame, before running it) */
+extern void rewind_push(void);
+
+/* Restore the newest recorded state and drop it, keeping the oldest one */
+/* (returns 0 when nothing was recorded yet) */
+extern int rewind_pop(void);
+
+/* Forget all recorded states */
+extern void rewind_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _REWIND_H_ */
@@ -0,0 +1,201 @@
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include "runner.h"
+#include "backends/sound/sound_base.h"
+
+#ifdef USE_CORE_CONTEXT
+
+/* Weight of the newest frame in the smoothed cost of an instance (1/N) */
+#define RUNNER_COST_SMOOTHING 8
+
+typedef struct
+{
+  t_context *ctx;
+  uint16 pad[MAX_DEVICES];
+  t_bitmap bitmap;
+  int interlaced;
+  short samples[SOUND_SAMPLES_SIZE];
+  int sample_count;
+  double cost;
+} t_runner_instance;
+
+static t_runner_instance runner_instances[RUNNER_MAX_INSTANCES];
+static int runner_instance_count;
+
+/* Order in which instances are handed out during the current frame */
+static int runner_order[RUNNER_MAX_INSTANCES];
+static std::atomic<int> runner_next;
+static std::atomic<int> runner_pending;
+
+static std::vector<std::thread> runner_workers;
+static std::mutex runner_mutex;
+static std::condition_variable runner_start;
+static std::condition_variable runner_done;
+static unsigned int runner_generation;
+static bool runner_exit;
+
+static void runner_step(t_runner_instance *inst) {
+  auto start = std::chrono::steady_clock::now();
+
+  context_select(inst->ctx);
+
+  for (int i = 0; i < MAX_DEVICES; i++)
+    input.pad[i] = inst->pad[i];
+
+  if (system_hw == SYSTEM_MCD)
+    system_frame_scd(0);
+  else if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
+    system_frame_gen(0);
+  else
+    system_frame_sms(0);
+
+  inst->sample_count = audio_update(inst->samples);
+  inst->bitmap = bitmap;
+  inst->interlaced = interlaced;
+
+  /* release the instance so any worker can pick it up next frame */
+  context_select(NULL);
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  inst->cost += (elapsed.count() - inst->cost) / RUNNER_COST_SMOOTHING;
+}
+
+static void runner_work(void) {
+  int next;
+
+  while ((next = runner_next.fetch_add(1)) < runner_instance_count) {
+    runner_step(&runner_instances[runner_order[next]]);
+
+    if (runner_pending.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(runner_mutex);
+      runner_done.notify_one();
+    }
+  }
+}
+
+static void runner_worker(void) {
+  unsigned int generation = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(runner_mutex);
+      runner_start.wait(lock, [&] { return runner_exit || (runner_generation != generation); });
+      if (runner_exit) return;
+      generation = runner_generation;
+    }
+
+    runner_work();
+  }
+}
+
+int runner_init(int threads) {
+  if (threads <= 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  runner_instance_count = 0;
+  runner_generation = 0;
+  runner_exit = false;
+  runner_next.store(0);
+  runner_pending.store(0);
+
+  /* the thread calling runner_frame is one of the workers */
+  for (int i = 1; i < threads; i++)
+    runner_workers.emplace_back(runner_worker);
+
+  return threads;
+}
+
+void runner_close(void) {
+  {
+    std::lock_guard<std::mutex> lock(runner_mutex);
+    runner_exit = true;
+  }
+  runner_start.notify_all();
+
+  for (auto &worker : runner_workers)
+    worker.join();
+  runner_workers.clear();
+}
+
+int runner_add(t_context *ctx) {
+  if (runner_instance_count == RUNNER_MAX_INSTANCES)
+    return -1;
+
+  t_runner_instance *inst = &runner_instances[runner_instance_count];
+  memset(inst, 0, sizeof(t_runner_instance));
+  inst->ctx = ctx;
+  return runner_instance_count++;
+}
+
+int runner_count(void) {
+  return runner_instance_count;
+}
+
+void runner_set_pad(int index, int player, uint16 pad) {
+  runner_instances[index].pad[player] = pad;
+}
+
+void runner_frame(void) {
+  int count = runner_instance_count;
+
+  /* most expensive instances first */
+  for (int i = 0; i < count; i++)
+    runner_order[i] = i;
+  std::stable_sort(runner_order, runner_order + count, [](int a, int b) {
+    return runner_instances[a].cost > runner_instances[b].cost;
+  });
+
+  /* pending must be set before any worker can grab an instance */
+  runner_pending.store(count);
+  runner_next.store(0);
+
+  {
+    std::lock_guard<std::mutex> lock(runner_mutex);
+    runner_generation++;
+  }
+  runner_start.notify_all();
+
+  runner_work();
+
+  std::unique_lock<std::mutex> lock(runner_mutex);
+  runner_done.wait(lock, [] { return runner_pending.load() == 0; });
+}
+
+const t_bitmap *runner_bitmap(int index) {
+  return &runner_instances[index].bitmap;
+}
+
+const short *runner_samples(int index, int *count) {
+  *count = runner_instances[index].sample_count;
+  return runner_instances[index].samples;
+}
+
+double runner_cost(int index) {
+  return runner_instances[index].cost;
+}
+
+int runner_compose(uint8 *dst, int pitch, int height) {
+  int y = 0;
+
+  for (int i = 0; i < runner_instance_count; i++) {
+    const t_bitmap *src = &runner_instances[i].bitmap;
+    int rows = src->viewport.h + (2 * src->viewport.y);
+    if (runner_instances[i].interlaced) rows += src->viewport.h;
+    rows = std::min(rows, height - y);
+
+    for (int line = 0; line < rows; line++)
+      memcpy(dst + ((y + line) * pitch), src->data + (line * src->pitch), std::min(pitch, src->pitch));
+
+    y += rows;
+  }
+
+  return y;
+}
+
+#endif /* USE_CORE_CONTEXT */
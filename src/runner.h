@@ -0,0 +1,58 @@
+#ifndef _RUNNER_H_
+#define _RUNNER_H_
+
+#include "shared.h"
+
+/****************************************************************************
+ * Parallel multi-console runner (MULTI_INSTANCE=1 builds)
+ *
+ * Steps every registered emulator instance by one frame across a pool of
+ * worker threads and returns once all of them are done, so the presenter
+ * gets a complete set of frames at once. Each frame, instances are handed
+ * out most expensive first (going by their recent frame times) and idle
+ * workers grab the next one, so a slow Mega CD instance starts early
+ * instead of holding everyone up at the end of the frame.
+ *
+ * Instances are prepared by the caller (context_create, load_rom,
+ * system_init...) and must be released with context_select(NULL) before
+ * being added. The calling thread works too, so one thread means no pool.
+ *
+ ****************************************************************************/
+
+#define RUNNER_MAX_INSTANCES 16
+
+#ifdef USE_CORE_CONTEXT
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Start the worker pool (threads <= 0 means one per CPU core) */
+extern int runner_init(int threads);
+extern void runner_close(void);
+
+/* Register a prepared instance (returns its index, -1 if full) */
+extern int runner_add(t_context *ctx);
+extern int runner_count(void);
+
+/* Digital inputs applied to an instance before its next frame */
+extern void runner_set_pad(int index, int player, uint16 pad);
+
+/* Step all instances by one frame */
+extern void runner_frame(void);
+
+/* Results of the last frame */
+extern const t_bitmap *runner_bitmap(int index);
+extern const short *runner_samples(int index, int *count);
+extern double runner_cost(int index);
+
+/* Stack the last frame of every instance into one buffer (returns rows used) */
+extern int runner_compose(uint8 *dst, int pitch, int height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USE_CORE_CONTEXT */
+
+#endif /* _RUNNER_H_ */